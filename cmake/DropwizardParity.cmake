@@ -0,0 +1,73 @@
+#  Copyright 2019 Benjamin Bader
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+# Wires up run_parity_bench, which times the workloads in
+# test/DropwizardParity.java against Dropwizard Metrics and hands the
+# results to parity_bench for a side-by-side comparison.
+#
+# Needs a JDK and a metrics-core jar, either named by DROPWIZARD_METRICS_JAR
+# or found in the local Maven repository.  Without them the target is
+# skipped; parity_bench still runs the cppmetrics half on its own.
+
+set(DROPWIZARD_METRICS_JAR "" CACHE FILEPATH "metrics-core jar for the Dropwizard parity benchmark")
+
+if(NOT DROPWIZARD_METRICS_JAR)
+  file(GLOB _dropwizard_jars
+    "$ENV{HOME}/.m2/repository/io/dropwizard/metrics/metrics-core/*/metrics-core-*[0-9].jar")
+  if(_dropwizard_jars)
+    list(SORT _dropwizard_jars)
+    list(REVERSE _dropwizard_jars)
+    list(GET _dropwizard_jars 0 _dropwizard_jar)
+    set(DROPWIZARD_METRICS_JAR "${_dropwizard_jar}" CACHE FILEPATH "metrics-core jar for the Dropwizard parity benchmark" FORCE)
+  endif()
+endif()
+
+find_package(Java 1.8 QUIET COMPONENTS Development Runtime)
+
+if(NOT Java_FOUND)
+  message(STATUS "Dropwizard parity benchmark: no JDK found, skipping")
+  return()
+endif()
+
+if(NOT DROPWIZARD_METRICS_JAR OR NOT EXISTS "${DROPWIZARD_METRICS_JAR}")
+  message(STATUS "Dropwizard parity benchmark: no metrics-core jar found, skipping (set DROPWIZARD_METRICS_JAR)")
+  return()
+endif()
+
+message(STATUS "Dropwizard parity benchmark: using ${DROPWIZARD_METRICS_JAR}")
+
+include(UseJava)
+
+add_jar(dropwizard_parity
+  SOURCES
+    ${CMAKE_CURRENT_SOURCE_DIR}/test/DropwizardParity.java
+    ${CMAKE_CURRENT_SOURCE_DIR}/test/LongAdderBench.java
+  INCLUDE_JARS ${DROPWIZARD_METRICS_JAR}
+)
+
+get_target_property(_dropwizard_parity_jar dropwizard_parity JAR_FILE)
+
+if(WIN32)
+  set(_classpath "${_dropwizard_parity_jar};${DROPWIZARD_METRICS_JAR}")
+else()
+  set(_classpath "${_dropwizard_parity_jar}:${DROPWIZARD_METRICS_JAR}")
+endif()
+
+add_custom_target(run_parity_bench
+  COMMAND ${Java_JAVA_EXECUTABLE} -cp "${_classpath}" DropwizardParity dropwizard_parity.txt
+  COMMAND parity_bench dropwizard_parity.txt
+  DEPENDS parity_bench dropwizard_parity
+  WORKING_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR}
+  VERBATIM
+)
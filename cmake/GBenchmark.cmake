@@ -0,0 +1,43 @@
+#  Copyright 2019 Benjamin Bader
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+# Set up Google Benchmark
+configure_file(${CMAKE_CURRENT_LIST_DIR}/GBenchmarkCMakeLists.txt.in ${CMAKE_BINARY_DIR}/googlebenchmark-download/CMakeLists.txt)
+execute_process(COMMAND ${CMAKE_COMMAND} -G "${CMAKE_GENERATOR}" .
+  RESULT_VARIABLE result
+  WORKING_DIRECTORY ${CMAKE_BINARY_DIR}/googlebenchmark-download
+)
+
+if(result)
+  message(FATAL_ERROR "CMake step for google benchmark failed: ${result}")
+endif()
+
+execute_process(COMMAND ${CMAKE_COMMAND} --build .
+  RESULT_VARIABLE result
+  WORKING_DIRECTORY ${CMAKE_BINARY_DIR}/googlebenchmark-download
+)
+
+if(result)
+  message(FATAL_ERROR "Build step for google benchmark failed: ${result}")
+endif()
+
+set(BENCHMARK_ENABLE_TESTING OFF CACHE BOOL "" FORCE)
+set(BENCHMARK_ENABLE_GTEST_TESTS OFF CACHE BOOL "" FORCE)
+set(BENCHMARK_ENABLE_INSTALL OFF CACHE BOOL "" FORCE)
+
+add_subdirectory(
+  ${CMAKE_BINARY_DIR}/googlebenchmark-src
+  ${CMAKE_BINARY_DIR}/googlebenchmark-build
+  EXCLUDE_FROM_ALL
+)
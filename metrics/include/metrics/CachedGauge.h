@@ -0,0 +1,60 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef CPPMETRICS_CACHEDGAUGE_H
+#define CPPMETRICS_CACHEDGAUGE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+#include <metrics/Gauge.h>
+
+namespace cppmetrics {
+
+class Clock;
+
+/**
+ * Like a CallbackGauge, but remembers its value for |ttl|, for when
+ * computing it is expensive - walking a data structure, say.  However
+ * many readers poll it, the function runs at most once per |ttl|.
+ */
+class CachedGauge : public GaugeBase
+{
+public:
+  CachedGauge(std::function<long()> fn, const std::chrono::nanoseconds& ttl, Clock* clock = nullptr);
+
+  long get() override;
+
+  Epoch::value_t last_update_epoch() const noexcept override;
+
+  std::size_t memory_usage() const noexcept override;
+
+private:
+  std::function<long()> m_fn;
+  std::chrono::nanoseconds m_ttl;
+  Clock* m_clock;
+
+  std::mutex m_mutex;
+  std::atomic_long m_cached;
+  std::atomic_bool m_valid;
+  std::atomic<std::int64_t> m_expires_at;
+};
+
+}
+
+#endif
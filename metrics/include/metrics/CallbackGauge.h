@@ -0,0 +1,50 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef CPPMETRICS_CALLBACKGAUGE_H
+#define CPPMETRICS_CALLBACKGAUGE_H
+
+#include <cstddef>
+#include <functional>
+
+#include <metrics/Gauge.h>
+
+namespace cppmetrics {
+
+/**
+ * A gauge whose value is computed by a function each time it is read,
+ * so that nothing needs to be pushed from the code being measured.
+ *
+ * The function may be called from any thread that reads the gauge,
+ * typically a reporter's.  Since it is always current, a callback gauge
+ * is never considered idle.
+ */
+class CallbackGauge : public GaugeBase
+{
+public:
+  explicit CallbackGauge(std::function<long()> fn);
+
+  long get() override;
+
+  Epoch::value_t last_update_epoch() const noexcept override;
+
+  std::size_t memory_usage() const noexcept override;
+
+private:
+  std::function<long()> m_fn;
+};
+
+}
+
+#endif
@@ -19,9 +19,19 @@
 
 namespace cppmetrics {
 
+/**
+ * The source of time for all metrics.
+ *
+ * tick() is a monotonic count of nanoseconds from an unspecified epoch;
+ * it is only meaningful relative to other ticks from the same clock, and
+ * is what every duration, rate and decay is measured with.
+ * now_as_time_t() is wall-clock time, for timestamping reports.
+ */
 class Clock
 {
 public:
+  virtual ~Clock() = default;
+
   virtual std::chrono::nanoseconds tick();
   virtual time_t now_as_time_t();
 };
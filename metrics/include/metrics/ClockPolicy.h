@@ -0,0 +1,96 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef CPPMETRICS_METRICS_CLOCKPOLICY_H
+#define CPPMETRICS_METRICS_CLOCKPOLICY_H
+
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+
+#include <metrics/Clock.h>
+
+namespace cppmetrics {
+
+/**
+ * Clock policies supply the time to BasicMeter and BasicTimer.  A policy
+ * is a small, copyable value with the same two members as Clock:
+ *
+ *   std::chrono::nanoseconds tick();
+ *   time_t now_as_time_t();
+ */
+
+/**
+ * Reads time through a Clock*, chosen at runtime.  This is what Meter and
+ * Timer use, so that tests can substitute a ManualClock.  Implicitly
+ * constructible from a Clock*; null means the default clock.
+ */
+class ClockRef
+{
+public:
+  ClockRef(Clock* clock = nullptr)
+      : m_clock(clock != nullptr ? clock : GetDefaultClock())
+  {}
+
+  std::chrono::nanoseconds tick() const
+  {
+    return m_clock->tick();
+  }
+
+  time_t now_as_time_t() const
+  {
+    return m_clock->now_as_time_t();
+  }
+
+  Clock* get() const noexcept
+  {
+    return m_clock;
+  }
+
+private:
+  Clock* m_clock;
+};
+
+/**
+ * Reads std::chrono::steady_clock directly.  Equivalent to the default
+ * Clock, but known at compile time, so the read can be inlined.
+ */
+class SteadyClockPolicy
+{
+public:
+  std::chrono::nanoseconds tick() const noexcept
+  {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch());
+  }
+
+  time_t now_as_time_t() const noexcept
+  {
+    return std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+  }
+};
+
+// Meter.h explains InlineWindows; three fits the default windows.
+template <typename ClockPolicy, std::size_t InlineWindows = 3> class BasicMeter;
+template <typename ClockPolicy> class BasicTimer;
+
+using Meter = BasicMeter<ClockRef>;
+using Timer = BasicTimer<ClockRef>;
+
+using SteadyMeter = BasicMeter<SteadyClockPolicy>;
+using SteadyTimer = BasicTimer<SteadyClockPolicy>;
+
+}
+
+#endif
@@ -0,0 +1,79 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef CPPMETRICS_METRICS_COARSECLOCK_H
+#define CPPMETRICS_METRICS_COARSECLOCK_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <thread>
+
+#include <metrics/Clock.h>
+
+namespace cppmetrics {
+
+/**
+ * A Clock that serves cached timestamps, refreshed from another clock
+ * by a background thread.
+ *
+ * Reading it is a single relaxed atomic load, at the cost of being up
+ * to |resolution| stale.  That is plenty for meters ticking every five
+ * seconds, or for reservoirs rescaling every hour, and takes a clock
+ * read off every mark and update.  Use it for anything that does not
+ * measure durations.
+ */
+class CoarseClock : public Clock
+{
+public:
+  explicit CoarseClock(Clock* source = nullptr,
+                       const std::chrono::nanoseconds& resolution = std::chrono::milliseconds(1));
+  ~CoarseClock() override;
+
+  CoarseClock(const CoarseClock&) = delete;
+  CoarseClock& operator=(const CoarseClock&) = delete;
+
+  std::chrono::nanoseconds tick() override;
+  time_t now_as_time_t() override;
+
+  std::chrono::nanoseconds get_resolution() const noexcept;
+
+private:
+  void refresh();
+  void loop_refreshing();
+
+private:
+  Clock* m_source;
+  std::chrono::nanoseconds m_resolution;
+  std::atomic<std::int64_t> m_tick;
+  std::atomic<time_t> m_time;
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_running;
+  std::thread m_thread;
+};
+
+/**
+ * Returns a shared CoarseClock over the default clock, with a
+ * resolution of one millisecond.
+ */
+Clock* GetCoarseClock();
+
+}
+
+#endif
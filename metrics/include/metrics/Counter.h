@@ -15,7 +15,9 @@
 #ifndef CPPMETRICS_METRICS_COUNTER_H
 #define CPPMETRICS_METRICS_COUNTER_H
 
+#include <cstddef>
 #include <cstdint>
+#include <metrics/Epoch.h>
 #include <metrics/LongAdder.h>
 
 namespace cppmetrics {
@@ -36,9 +38,13 @@ public:
   void dec(value_t n = 1);
 
   LongAdder::value_t get_count() const noexcept;
+  Epoch::value_t last_update_epoch() const noexcept;
+
+  std::size_t memory_usage() const noexcept;
 
 private:
   LongAdder m_adder;
+  EpochStamp m_stamp;
 };
 
 } // namespace cppmetrics
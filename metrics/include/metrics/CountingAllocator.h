@@ -0,0 +1,95 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef CPPMETRICS_COUNTINGALLOCATOR_H
+#define CPPMETRICS_COUNTINGALLOCATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace cppmetrics {
+
+/**
+ * A std::allocator that keeps a running total of the bytes it has handed
+ * out and not yet had back, so that a container can report its own
+ * footprint (see the memory_usage() methods).
+ *
+ * Copies and rebinds share one total; a node-based container's nodes are
+ * counted along with anything else allocated through copies of the same
+ * allocator.  Allocators compare equal only when they share a total.
+ */
+template <typename T>
+class CountingAllocator
+{
+public:
+  using value_type = T;
+
+  CountingAllocator()
+    : m_bytes(std::make_shared<std::atomic<std::size_t>>(0))
+  {}
+
+  // Declared so that moving a container copies, rather than empties,
+  // the allocator it leaves behind.
+  CountingAllocator(const CountingAllocator&) = default;
+
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>& other) noexcept
+    : m_bytes(other.m_bytes)
+  {}
+
+  T* allocate(std::size_t n)
+  {
+    T* result = std::allocator<T>().allocate(n);
+    m_bytes->fetch_add(n * sizeof(T), std::memory_order_relaxed);
+    return result;
+  }
+
+  void deallocate(T* ptr, std::size_t n) noexcept
+  {
+    m_bytes->fetch_sub(n * sizeof(T), std::memory_order_relaxed);
+    std::allocator<T>().deallocate(ptr, n);
+  }
+
+  /**
+   * The number of bytes currently allocated through this allocator
+   * and its copies.
+   */
+  std::size_t bytes() const noexcept
+  {
+    return m_bytes->load(std::memory_order_relaxed);
+  }
+
+  template <typename U>
+  bool operator==(const CountingAllocator<U>& other) const noexcept
+  {
+    return m_bytes == other.m_bytes;
+  }
+
+  template <typename U>
+  bool operator!=(const CountingAllocator<U>& other) const noexcept
+  {
+    return m_bytes != other.m_bytes;
+  }
+
+private:
+  template <typename U>
+  friend class CountingAllocator;
+
+  std::shared_ptr<std::atomic<std::size_t>> m_bytes;
+};
+
+}
+
+#endif
@@ -0,0 +1,62 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef CPPMETRICS_DERIVATIVEGAUGE_H
+#define CPPMETRICS_DERIVATIVEGAUGE_H
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include <metrics/DoubleGauge.h>
+
+namespace cppmetrics {
+
+class Clock;
+class Counter;
+
+/**
+ * Reports how fast another value is changing: the per-second change in
+ * |source| between one read of this gauge and the next.  Reads zero the
+ * first time, and whenever no time has passed since the previous read.
+ *
+ * Since the rate is between reads, this is best read by one reporter.
+ */
+class DerivativeGauge : public DoubleGaugeBase
+{
+public:
+  DerivativeGauge(std::function<double()> source, Clock* clock = nullptr);
+  DerivativeGauge(std::shared_ptr<Counter> counter, Clock* clock = nullptr);
+
+  double get() override;
+
+  Epoch::value_t last_update_epoch() const noexcept override;
+
+  std::size_t memory_usage() const noexcept override;
+
+private:
+  std::function<double()> m_source;
+  Clock* m_clock;
+
+  std::mutex m_mutex;
+  bool m_has_previous;
+  double m_previous_value;
+  std::chrono::nanoseconds m_previous_time;
+};
+
+}
+
+#endif
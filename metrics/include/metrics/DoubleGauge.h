@@ -0,0 +1,68 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef CPPMETRICS_DOUBLEGAUGE_H
+#define CPPMETRICS_DOUBLEGAUGE_H
+
+#include <atomic>
+#include <cstddef>
+
+#include <metrics/Epoch.h>
+
+namespace cppmetrics {
+
+/**
+ * GaugeBase for fractional values: DoubleGauge holds a value set by the
+ * application, while RatioGauge and DerivativeGauge compute theirs when
+ * read.
+ */
+class DoubleGaugeBase
+{
+public:
+  virtual ~DoubleGaugeBase() = default;
+
+  virtual double get() = 0;
+
+  virtual Epoch::value_t last_update_epoch() const noexcept = 0;
+
+  /**
+   * The bytes this gauge occupies.  State held by a std::function
+   * is not counted.
+   */
+  virtual std::size_t memory_usage() const noexcept = 0;
+};
+
+/**
+ * A Gauge for fractional values.
+ */
+class DoubleGauge : public DoubleGaugeBase
+{
+public:
+  DoubleGauge();
+
+  void set(double value);
+  double get() override;
+
+  Epoch::value_t last_update_epoch() const noexcept override;
+
+  std::size_t memory_usage() const noexcept override;
+
+private:
+  std::atomic<double> m_value;
+  EpochStamp m_stamp;
+};
+
+}
+
+#endif
@@ -17,6 +17,7 @@
 
 #include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <memory>
 
 namespace cppmetrics {
@@ -33,10 +34,31 @@ public:
   static std::shared_ptr<EWMA> five_minutes();
   static std::shared_ptr<EWMA> fifteen_minutes();
 
+  /**
+   * Computes the smoothing factor for an average over |window|, when
+   * ticked every |tick_interval|.
+   */
+  static double alpha_for(const std::chrono::nanoseconds& window, const std::chrono::nanoseconds& tick_interval);
+
   EWMA(double alpha, const std::chrono::system_clock::duration& tick_interval);
+  EWMA(EWMA&&) noexcept;
 
   void update(long n);
   void tick();
+
+  /**
+   * Equivalent to calling |tick| |ticks| times in a row, but takes
+   * constant time: anything pending is folded in by the first tick,
+   * and the remaining, empty ticks decay the rate in closed form.
+   */
+  void tick_n(std::uint64_t ticks);
+
+  /**
+   * Equivalent to |ticks| ticks with |count| events spread evenly across
+   * them, in constant time.  For callers that only learn how many events
+   * happened long after the fact.
+   */
+  void tick_spread(long count, std::uint64_t ticks);
   double get_rate(const std::chrono::duration<long>& period);
 
   template <typename Duration>
@@ -0,0 +1,91 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef CPPMETRICS_METRICS_EPOCH_H
+#define CPPMETRICS_METRICS_EPOCH_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace cppmetrics {
+
+/**
+ * A coarse, process-wide generation number.
+ *
+ * The epoch only moves forward when something (usually a Registry looking
+ * for idle metrics) calls |advance|.  It carries no notion of time by itself;
+ * whoever advances it is responsible for remembering when it did so.
+ */
+class Epoch
+{
+public:
+  using value_t = std::uint32_t;
+
+  static value_t current() noexcept
+  {
+    return s_current.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Moves to the next epoch, returning its value.
+   */
+  static value_t advance() noexcept;
+
+  /**
+   * Returns true if |lhs| is an earlier epoch than |rhs|, accounting
+   * for wraparound.
+   */
+  static bool is_before(value_t lhs, value_t rhs) noexcept
+  {
+    return static_cast<std::int32_t>(lhs - rhs) < 0;
+  }
+
+private:
+  static std::atomic<value_t> s_current;
+};
+
+/**
+ * Remembers the epoch in which its owner was last updated.
+ *
+ * Touching a stamp is a relaxed load of the global epoch and, at most once
+ * per epoch, a relaxed store; it never reads a clock.
+ */
+class EpochStamp
+{
+public:
+  EpochStamp() noexcept
+      : m_epoch(Epoch::current())
+  {}
+
+  void touch() noexcept
+  {
+    auto now = Epoch::current();
+    if (m_epoch.load(std::memory_order_relaxed) != now)
+    {
+      m_epoch.store(now, std::memory_order_relaxed);
+    }
+  }
+
+  Epoch::value_t get() const noexcept
+  {
+    return m_epoch.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::atomic<Epoch::value_t> m_epoch;
+};
+
+}
+
+#endif
@@ -18,10 +18,12 @@
 #include <atomic>
 #include <cstddef>
 #include <ctime>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <map>
 
+#include <metrics/CountingAllocator.h>
 #include <metrics/Reservoir.h>
 #include <metrics/WeightedSnapshot.h>
 
@@ -31,10 +33,10 @@ class Clock;
 
 class ExponentiallyDecayingReservoir : public Reservoir
 {
+public:
   static const std::size_t kDefaultSize;
   static const double kDefaultAlpha;
 
-public:
     ExponentiallyDecayingReservoir(std::size_t size = kDefaultSize, double alpha = kDefaultAlpha, Clock* clock = nullptr);
     ExponentiallyDecayingReservoir(ExponentiallyDecayingReservoir&&);
 
@@ -43,12 +45,17 @@ public:
 public:
     std::size_t size() const override;
     void update(long value) override;
+    void update_batch(const long* values, std::size_t n) override;
+    void update_weighted(long value, double weight) override;
 
     std::shared_ptr<Snapshot> get_snapshot() override;
+    std::size_t memory_usage() const noexcept override;
 
 private:
+    void update_locked(long value, double item_weight);
     void rescale_if_needed();
     void rescale(std::time_t now, std::time_t next);
+    void rescale_locked(std::time_t now);
 
 private:
     std::mutex m_mutex;
@@ -58,7 +65,9 @@ private:
     std::time_t m_next_rescale_time;
     std::size_t m_size;
     double m_alpha;
-    std::map<double, WeightedSample> m_samples;
+    // Counts its nodes, for memory_usage().
+    std::map<double, WeightedSample, std::less<double>,
+             CountingAllocator<std::pair<const double, WeightedSample>>> m_samples;
 };
 
 }
@@ -16,21 +16,53 @@
 #define CPPMETRICS_GAUGE_H
 
 #include <atomic>
+#include <cstddef>
 #include <map>
 #include <string>
 
+#include <metrics/Epoch.h>
+
 namespace cppmetrics {
 
-class Gauge
+/**
+ * What every gauge offers, however it comes by its value: Gauge holds a
+ * value set by the application, while CallbackGauge and CachedGauge
+ * compute theirs when read.
+ */
+class GaugeBase
+{
+public:
+  virtual ~GaugeBase() = default;
+
+  virtual long get() = 0;
+
+  virtual Epoch::value_t last_update_epoch() const noexcept = 0;
+
+  /**
+   * The bytes this gauge occupies.  State held by a std::function
+   * is not counted.
+   */
+  virtual std::size_t memory_usage() const noexcept = 0;
+};
+
+/**
+ * A single value, set by the application.
+ */
+class Gauge : public GaugeBase
 {
 public:
   Gauge();
 
   void set(long value);
-  long get();
+  long get() override;
+
+  Epoch::value_t last_update_epoch() const noexcept override;
+
+  std::size_t memory_usage() const noexcept override;
 
 private:
   std::atomic_long m_value;
+  EpochStamp m_stamp;
 };
 
 }
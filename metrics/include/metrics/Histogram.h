@@ -16,8 +16,10 @@
 #define CPPMETRICS_METRICS_HISTOGRAM_H
 
 #include <atomic>
+#include <cstddef>
 #include <memory>
 
+#include <metrics/Epoch.h>
 #include <metrics/Reservoir.h>
 
 namespace cppmetrics {
@@ -31,12 +33,22 @@ public:
 
   void update(long n);
 
+  /**
+   * Records |n| values with a single reservoir call.
+   */
+  void update_batch(const long* values, std::size_t n);
+
   long get_count() const;
   std::shared_ptr<Snapshot> get_snapshot();
 
+  Epoch::value_t last_update_epoch() const noexcept;
+
+  std::size_t memory_usage() const noexcept;
+
 private:
   std::atomic_long m_counter;
   std::unique_ptr<Reservoir> m_reservoir;
+  EpochStamp m_stamp;
 };
 
 }
@@ -0,0 +1,112 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef CPPMETRICS_METRICS_LATENCYTIMER_H
+#define CPPMETRICS_METRICS_LATENCYTIMER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include <metrics/EWMA.h>
+#include <metrics/LongAdder.h>
+#include <metrics/Reservoir.h>
+
+namespace cppmetrics {
+
+class Clock;
+class Snapshot;
+
+/**
+ * A Timer for when the latency distribution is what matters.
+ *
+ * Each update is one reservoir update and one striped add - no meter, no
+ * separate histogram count, and no clock read.  Rates are still available,
+ * but are derived from the count when they are read: everything recorded
+ * since the previous read is spread evenly over the five-second ticks
+ * that have passed since, and folded into the moving averages in one
+ * step.  A steady rate therefore reads the same however rarely it is
+ * read; bursts between reads are smoothed over the whole gap.
+ */
+class LatencyTimer
+{
+public:
+  LatencyTimer();
+  LatencyTimer(std::unique_ptr<Reservoir>&& reservoir);
+  LatencyTimer(std::unique_ptr<Reservoir>&& reservoir, Clock* clock);
+
+  void update(const std::chrono::nanoseconds& nanos);
+  void update(const std::chrono::milliseconds& millis);
+  void update_batch(const long* nanos, std::size_t n);
+
+  long get_count() const noexcept;
+  double get_m1_rate();
+  double get_m5_rate();
+  double get_m15_rate();
+  double get_mean_rate();
+  std::shared_ptr<Snapshot> get_snapshot();
+
+  std::size_t memory_usage() const noexcept;
+
+  /**
+   * Times its own lifetime into a LatencyTimer.
+   */
+  class Scope
+  {
+  public:
+    Scope(LatencyTimer& timer);
+    ~Scope();
+
+  private:
+    LatencyTimer& m_timer;
+    std::chrono::nanoseconds m_start;
+  };
+
+private:
+  friend class SampledTimer;
+
+  // update() is count() plus record(); samplers call them separately.
+  void count() noexcept;
+  void record(const std::chrono::nanoseconds& nanos);
+  void record(const std::chrono::nanoseconds& nanos, std::uint32_t weight);
+
+  void catch_up();
+
+private:
+  Clock* m_clock;
+  std::unique_ptr<Reservoir> m_reservoir;
+  LongAdder m_count;
+  std::chrono::nanoseconds m_start_time;
+
+  // Only touched by readers.
+  std::mutex m_rates_mutex;
+  std::chrono::nanoseconds m_last_tick;
+  LongAdder::value_t m_ticked_count;
+  EWMA m_m1;
+  EWMA m_m5;
+  EWMA m_m15;
+};
+
+template <typename Function>
+auto timed(LatencyTimer& timer, Function&& fn) -> decltype(fn())
+{
+  LatencyTimer::Scope scope(timer);
+  return fn();
+}
+
+}
+
+#endif
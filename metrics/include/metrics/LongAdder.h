@@ -16,6 +16,7 @@
 #define CPPMETRICS_METRICS_LONGADDER_H
 
 #include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -49,6 +50,12 @@ public:
 
   value_t count() const noexcept;
 
+  /**
+   * The bytes this adder occupies, including its cell table and
+   * whichever cells have been allocated so far.
+   */
+  std::size_t memory_usage() const noexcept;
+
 private:
   void modify(value_t n);
 
@@ -17,41 +17,188 @@
 
 #include <atomic>
 #include <chrono>
-#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include <metrics/ClockPolicy.h>
+#include <metrics/EWMA.h>
+#include <metrics/Epoch.h>
+#include <metrics/LongAdder.h>
 
 namespace cppmetrics {
 
-class Clock;
-class EWMA;
+/**
+ * What every BasicMeter shares, regardless of how it reads the clock.
+ */
+class MeterBase
+{
+public:
+  using duration = std::chrono::nanoseconds;
+
+  static const std::vector<duration>& default_windows();
+  static const duration kDefaultTickInterval;
+
+protected:
+  struct Window
+  {
+    Window(const duration& length, const duration& tick_interval);
+
+    duration length;
+    EWMA ewma;
+  };
+
+  /**
+   * @throws std::invalid_argument unless there is at least one window,
+   *         and every window and the tick interval are positive.
+   */
+  static void check_windows(const std::vector<duration>& lengths, const duration& tick_interval);
 
-class Meter
+  /**
+   * A fixed set of windows.  Up to InlineWindows of them live inside the
+   * meter; larger sets are allocated, at exactly their size.
+   */
+  template <std::size_t InlineWindows>
+  class Windows
+  {
+  public:
+    static_assert(InlineWindows > 0, "A meter has at least one window");
+
+    Windows(const std::vector<duration>& lengths, const duration& tick_interval);
+    ~Windows();
+
+    Windows(const Windows&) = delete;
+    Windows& operator=(const Windows&) = delete;
+
+    Window* begin() noexcept { return m_begin; }
+    Window* end() noexcept { return m_begin + m_size; }
+    const Window* begin() const noexcept { return m_begin; }
+    const Window* end() const noexcept { return m_begin + m_size; }
+    std::size_t size() const noexcept { return m_size; }
+
+    /**
+     * The bytes allocated outside the meter, if any.
+     */
+    std::size_t heap_bytes() const noexcept;
+
+  private:
+    bool is_inline() const noexcept;
+
+    typename std::aligned_storage<sizeof(Window), alignof(Window)>::type m_inline[InlineWindows];
+    Window* m_begin;
+    std::size_t m_size;
+  };
+};
+
+/**
+ * Measures the rate at which events occur.
+ *
+ * Marking a meter is a single striped add (see LongAdder).  The moving
+ * averages are not touched until the next tick, at which point whatever was
+ * marked since the previous tick is handed to them in one go.
+ *
+ * By default, meters tick themselves lazily: marking or reading a rate first
+ * checks the clock to see whether a tick is due.  A meter can instead be
+ * handed to an external ticker (see Registry::start_ticker), in which case
+ * marking never reads the clock at all.
+ *
+ * The set of averaged windows and the tick interval are configurable; the
+ * default is the classic one-, five- and fifteen-minute averages, ticked
+ * every five seconds.  Storage for |InlineWindows| windows, three by
+ * default, is part of the meter itself; a meter with more allocates them
+ * all.  A meter that only ever needs one window can be declared as
+ * BasicMeter<ClockRef, 1>, and is smaller for it.
+ *
+ * The clock is a compile-time policy (see ClockPolicy.h).  Meter reads it
+ * through a Clock*; SteadyMeter reads steady_clock directly, inlined.
+ * Both are instantiated in the library, with one to three inline
+ * windows; other policies and sizes are not.
+ */
+template <typename ClockPolicy, std::size_t InlineWindows>
+class BasicMeter : public MeterBase
 {
 public:
-  Meter(Clock* clock = nullptr);
+  BasicMeter(ClockPolicy clock = ClockPolicy());
+
+  /**
+   * @throws std::invalid_argument if |windows| is empty, or if any window
+   *         or |tick_interval| is not positive.
+   */
+  BasicMeter(const std::vector<duration>& windows, const duration& tick_interval, ClockPolicy clock = ClockPolicy());
 
   void mark(long n = 1);
 
   long get_count() const noexcept;
+
+  /**
+   * Shorthands for get_rate(15min), get_rate(5min) and get_rate(1min).
+   *
+   * @throws std::invalid_argument if the meter was created with custom
+   *         windows that don't include the one asked for.
+   */
   double get_m15_rate();
   double get_m5_rate();
   double get_m1_rate();
   double get_mean_rate();
 
+  /**
+   * Returns the per-second rate averaged over |window|, which must be
+   * one of the windows this meter was created with.
+   *
+   * @throws std::invalid_argument if the window isn't being tracked.
+   */
+  double get_rate(const duration& window);
+
+  std::vector<duration> get_windows() const;
+  duration get_tick_interval() const noexcept;
+
+  Epoch::value_t last_update_epoch() const noexcept;
+
+  std::size_t memory_usage() const noexcept;
+
+  /**
+   * Brings the moving averages up to date with the clock.  Only needed
+   * when the meter is externally ticked.
+   */
+  void tick();
+
+  /**
+   * When true, mark() and the rate getters no longer check whether a tick
+   * is due; something else must call |tick| at least once per interval.
+   */
+  void set_externally_ticked(bool externally_ticked) noexcept;
+
 private:
+  bool is_externally_ticked() const noexcept;
   void tick_if_necessary();
 
 private:
-  Clock* m_clock;
+  ClockPolicy m_clock;
+  duration m_tick_interval;
 
-  std::atomic_long m_count;
+  LongAdder m_count;
   std::chrono::nanoseconds m_start_time;
   std::atomic_llong m_last_tick;
 
-  std::shared_ptr<EWMA> m_m1;
-  std::shared_ptr<EWMA> m_m5;
-  std::shared_ptr<EWMA> m_m15;
+  // The value of m_count as of the most recent tick.
+  std::atomic<LongAdder::value_t> m_ticked_count;
+
+  std::atomic_bool m_externally_ticked;
+
+  // Contiguous, and only touched at tick time.
+  Windows<InlineWindows> m_windows;
+
+  EpochStamp m_stamp;
 };
 
+extern template class BasicMeter<ClockRef, 1>;
+extern template class BasicMeter<ClockRef, 2>;
+extern template class BasicMeter<ClockRef, 3>;
+extern template class BasicMeter<SteadyClockPolicy, 1>;
+extern template class BasicMeter<SteadyClockPolicy, 2>;
+extern template class BasicMeter<SteadyClockPolicy, 3>;
+
 }
 
 #endif
@@ -0,0 +1,51 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef CPPMETRICS_RATIOGAUGE_H
+#define CPPMETRICS_RATIOGAUGE_H
+
+#include <cstddef>
+#include <memory>
+
+#include <metrics/DoubleGauge.h>
+
+namespace cppmetrics {
+
+class Counter;
+
+/**
+ * The ratio of two counters - hits to lookups, say - computed only when
+ * it is read, so that the code being measured just increments counters.
+ *
+ * Reads NaN while the denominator is zero.
+ */
+class RatioGauge : public DoubleGaugeBase
+{
+public:
+  RatioGauge(std::shared_ptr<Counter> numerator, std::shared_ptr<Counter> denominator);
+
+  double get() override;
+
+  Epoch::value_t last_update_epoch() const noexcept override;
+
+  std::size_t memory_usage() const noexcept override;
+
+private:
+  std::shared_ptr<Counter> m_numerator;
+  std::shared_ptr<Counter> m_denominator;
+};
+
+}
+
+#endif
@@ -15,82 +15,515 @@
 #ifndef CPPMETRICS_METRICS_REGISTRY_H
 #define CPPMETRICS_METRICS_REGISTRY_H
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <set>
 #include <shared_mutex>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <metrics/ClockPolicy.h>
+#include <metrics/CountingAllocator.h>
+#include <metrics/Epoch.h>
+#include <metrics/SelfMetrics.h>
 
 namespace cppmetrics {
 
+class Clock;
+class FrozenIndex;
 class Gauge;
+class GaugeBase;
 class Counter;
-class Meter;
+class DoubleGauge;
+class DoubleGaugeBase;
 class Histogram;
-class Timer;
 
+enum class MetricType
+{
+  Gauge,
+  Counter,
+  Meter,
+  Histogram,
+  Timer,
+  DoubleGauge,
+};
+
+/**
+ * What a frozen Registry does when asked for a metric it doesn't have.
+ */
+enum class FreezePolicy
+{
+  // Create it as usual; it lives outside the frozen index.
+  AllowOverflow,
+
+  // Throw std::logic_error.
+  RejectNew,
+};
+
+/**
+ * A named collection of metrics.
+ *
+ * Metrics are partitioned into shards by the hash of their name.  Each shard
+ * has its own index and lock, so creating or looking up metrics with different
+ * names rarely contends on the same mutex.  The get_* accessors merge all
+ * shards into a single, name-ordered view for reporters.
+ *
+ * Metrics can be removed explicitly, or evicted once they have gone unused
+ * for longer than an idle TTL.  Removal only drops the registry's reference;
+ * callers still holding a metric can keep using it safely, although its
+ * updates will no longer be reported.
+ *
+ * Once the set of metrics is stable, |freeze| compiles the registry into an
+ * immutable, perfectly-hashed index; after that, looking up a frozen metric
+ * takes no locks at all.
+ *
+ * Optionally, a registry can run a background ticker that advances the
+ * moving averages of all of its meters and timers in one batch, so that
+ * marking them never needs to consult a clock.
+ */
 class Registry
 {
 public:
+  static const std::size_t kDefaultShardCount;
+
+  explicit Registry(std::size_t shard_count = kDefaultShardCount);
+  ~Registry();
+
+  /**
+   * Gets or creates a gauge to set.  Like a name taken by another kind of
+   * metric, one taken by a computed gauge yields nullptr, since it can't
+   * be set.
+   */
   std::shared_ptr<Gauge>     gauge(const std::string& name);
   std::shared_ptr<Counter>   counter(const std::string& name);
   std::shared_ptr<Meter>     meter(const std::string& name);
   std::shared_ptr<Histogram> histogram(const std::string& name);
   std::shared_ptr<Timer>     timer(const std::string& name);
 
-  std::map<std::string, std::shared_ptr<Gauge>>     get_gauges();
+  /**
+   * Gets or creates a gauge whose value is computed by |fn| whenever it is
+   * read (see CallbackGauge).  If |ttl| is given, the value is cached for
+   * that long (see CachedGauge).  If a gauge by that name already exists,
+   * it is returned as-is.
+   */
+  std::shared_ptr<GaugeBase> gauge(const std::string& name, std::function<long()> fn);
+  std::shared_ptr<GaugeBase> gauge(const std::string& name, std::function<long()> fn, const std::chrono::nanoseconds& ttl);
+
+  /**
+   * Gets or creates a double gauge to set; as with gauge(), a name taken
+   * by a computed one yields nullptr.
+   */
+  std::shared_ptr<DoubleGauge> double_gauge(const std::string& name);
+
+  /**
+   * Gets or creates a meter averaging over the given |windows|, ticked
+   * every |tick_interval|.  If a meter by that name already exists, it
+   * is returned as-is.
+   *
+   * @throws std::invalid_argument as BasicMeter's constructor does.
+   */
+  std::shared_ptr<Meter> meter(const std::string& name,
+                               const std::vector<std::chrono::nanoseconds>& windows,
+                               const std::chrono::nanoseconds& tick_interval);
+
+  /**
+   * Registers an existing metric under the given name.
+   *
+   * @return false if the name is already in use, in which case
+   *         the registry is unchanged.
+   */
+  bool add(const std::string& name, const std::shared_ptr<GaugeBase>& gauge);
+  bool add(const std::string& name, const std::shared_ptr<DoubleGaugeBase>& gauge);
+  bool add(const std::string& name, const std::shared_ptr<Counter>& counter);
+  bool add(const std::string& name, const std::shared_ptr<Meter>& meter);
+  bool add(const std::string& name, const std::shared_ptr<Histogram>& histogram);
+  bool add(const std::string& name, const std::shared_ptr<Timer>& timer);
+
+  /**
+   * Registers every metric declared with the CPPMETRICS_* macros
+   * (see StaticMetrics.h) that is not already present.
+   *
+   * @return the number of metrics added.
+   */
+  std::size_t register_static_metrics();
+
+  /**
+   * Creates a metric of the given type for each name not already in use,
+   * taking each shard's lock only once.
+   *
+   * @return the number of metrics created.
+   */
+  std::size_t register_all(MetricType type, const std::vector<std::string>& names);
+
+  /**
+   * Compiles every metric currently registered into an immutable,
+   * perfectly-hashed index that subsequent lookups consult without locking.
+   * |policy| decides what happens to requests for new metrics afterwards.
+   *
+   * Frozen metrics can no longer be removed or evicted.  Freezing again
+   * folds any overflow metrics into a new index.
+   */
+  void freeze(FreezePolicy policy = FreezePolicy::AllowOverflow);
+
+  bool is_frozen() const noexcept;
+
+  /**
+   * Starts a background thread that ticks every meter and timer in this
+   * registry once per |interval|.  While it runs, those meters are marked
+   * without reading the clock.  Meters that leave the registry go back to
+   * ticking themselves.
+   *
+   * Each meter still keeps its own tick interval.  One that ticks more
+   * often than |interval| catches up on every tick it missed, with the
+   * marks in between spread evenly across them.
+   */
+  void start_ticker(const std::chrono::nanoseconds& interval = std::chrono::seconds(5));
+  void stop_ticker();
+
+  std::map<std::string, std::shared_ptr<GaugeBase>> get_gauges();
   std::map<std::string, std::shared_ptr<Counter>>   get_counters();
   std::map<std::string, std::shared_ptr<Meter>>     get_meters();
   std::map<std::string, std::shared_ptr<Histogram>> get_histograms();
   std::map<std::string, std::shared_ptr<Timer>>     get_timers();
+  std::map<std::string, std::shared_ptr<DoubleGaugeBase>> get_double_gauges();
+
+  std::size_t shard_count() const noexcept;
+
+  /**
+   * Removes the metric with the given name, of whatever type.
+   *
+   * @return true if a metric was removed.
+   */
+  bool remove(const std::string& name);
+
+  /**
+   * Removes every metric whose name satisfies |predicate|.  The predicate
+   * is called with a shard lock held, and must not use this registry.
+   *
+   * @return the number of metrics removed.
+   */
+  std::size_t remove_if(const std::function<bool(const std::string&)>& predicate);
+
+  /**
+   * Enables idle expiry: metrics that have not been updated for at least
+   * |ttl| become eligible for eviction by |evict_idle|.  A TTL of zero
+   * disables expiry.
+   *
+   * Idleness is tracked with per-metric epoch stamps (see Epoch), so the
+   * metrics themselves never read a clock to support this.  Eviction
+   * is therefore only as precise as the interval between calls to
+   * |evict_idle|.
+   */
+  void set_idle_ttl(const std::chrono::nanoseconds& ttl, Clock* clock = nullptr);
+
+  /**
+   * Removes metrics that have been idle for at least the configured TTL.
+   * Intended to be called periodically, e.g. alongside reporting.
+   *
+   * @return the number of metrics evicted.
+   */
+  std::size_t evict_idle();
+
+  /**
+   * The bytes this registry occupies: its shards and index, the names
+   * it holds, and every metric registered in it.  Metrics also held
+   * elsewhere are counted all the same.
+   */
+  std::size_t memory_usage();
+
+  /**
+   * Turns on SelfMetrics, process-wide, and registers them here under
+   * |prefix|:
+   *
+   *   <prefix>.reporter.report          timer, one ScheduledReporter pass
+   *   <prefix>.snapshot.build           timer, building a reservoir snapshot
+   *   <prefix>.reservoir.rescale        timer, rescaling a decaying reservoir
+   *   <prefix>.reservoir.lock_wait      timer, contended reservoir lock waits
+   *   <prefix>.long_adder.cas_failures  counter, failed LongAdder CASes
+   *   <prefix>.long_adder.rehashes      counter, LongAdder cell rehashes
+   *   <prefix>.registry.lookups         counter, metric lookups by name
+   *   <prefix>.registry.creations       counter, metrics created on lookup
+   *
+   * Names already in use are left alone.  SelfMetrics::set_enabled(false)
+   * stops collection again.
+   */
+  void enable_self_metrics(const std::string& prefix = "cppmetrics");
 
 private:
+  template <typename T>
+  using MetricMap = std::map<std::string, std::shared_ptr<T>, std::less<std::string>,
+                             CountingAllocator<std::pair<const std::string, std::shared_ptr<T>>>>;
+
+  struct Shard
+  {
+    Shard();
+
+    std::shared_timed_mutex mutex;
+
+    // Shared by the containers below, so that it counts all of their nodes.
+    CountingAllocator<char> allocator;
+
+    std::set<std::string, std::less<std::string>, CountingAllocator<std::string>> names;
+    MetricMap<GaugeBase> gauges;
+    MetricMap<Counter>   counters;
+    MetricMap<Meter>     meters;
+    MetricMap<Histogram> histograms;
+    MetricMap<Timer>     timers;
+    MetricMap<DoubleGaugeBase> double_gauges;
+  };
+
+  template <typename T>
+  using Collection = MetricMap<T> Shard::*;
+
+  std::size_t shard_index(const std::string& name) const noexcept;
+  Shard& shard_for(const std::string& name);
+
   template <typename T, typename Factory>
   std::shared_ptr<T> get_or_add(
       const std::string& name,
-      std::map<std::string, std::shared_ptr<T>>& collection,
+      MetricType type,
+      Collection<T> collection,
       Factory&& factory);
 
+  template <typename T, typename Factory>
+  std::size_t add_all(
+      const std::vector<std::string>& names,
+      Collection<T> collection,
+      Factory&& factory);
+
+  bool find_frozen(const std::string& name, MetricType type, std::shared_ptr<void>& metric) const;
+  bool is_frozen_name(const std::string& name) const;
+  void ensure_not_rejecting() const;
+
+  void tick_all();
+  void loop_ticking();
+  void set_externally_ticked(bool externally_ticked);
+
+  // Called with the shard's exclusive lock held.
+  template <typename T>
+  void on_added(const std::shared_ptr<T>&) {}
+  void on_added(const std::shared_ptr<Meter>& meter);
+  void on_added(const std::shared_ptr<Timer>& timer);
+
+  template <typename T>
+  static void on_removed(const std::shared_ptr<T>&) {}
+  static void on_removed(const std::shared_ptr<Meter>& meter);
+  static void on_removed(const std::shared_ptr<Timer>& timer);
+
+  template <typename T>
+  bool put(const std::string& name, Collection<T> collection, const std::shared_ptr<T>& metric);
+
+  template <typename T>
+  void insert_locked(Shard& shard, Collection<T> collection, const std::string& name, const std::shared_ptr<T>& metric);
+
+  template <typename T>
+  std::map<std::string, std::shared_ptr<T>> collect(Collection<T> collection);
+
+  template <typename T>
+  std::size_t evict_from(Shard& shard, Collection<T> collection, Epoch::value_t cutoff);
+
+  static void erase_locked(Shard& shard, const std::string& name);
+
 private:
-  std::shared_timed_mutex m_mutex;
-
-  std::set<std::string> m_names;
-  std::map<std::string, std::shared_ptr<Gauge>>     m_gauges;
-  std::map<std::string, std::shared_ptr<Counter>>   m_counters;
-  std::map<std::string, std::shared_ptr<Meter>>     m_meters;
-  std::map<std::string, std::shared_ptr<Histogram>> m_histograms;
-  std::map<std::string, std::shared_ptr<Timer>>     m_timers;
+  std::vector<std::unique_ptr<Shard>> m_shards;
+
+  std::mutex m_expiry_mutex;
+  Clock* m_expiry_clock;
+  std::chrono::nanoseconds m_idle_ttl;
+
+  // Epochs this registry has started, and when, oldest first.
+  std::deque<std::pair<Epoch::value_t, std::chrono::nanoseconds>> m_sweeps;
+
+  std::mutex m_freeze_mutex;
+  std::atomic<const FrozenIndex*> m_frozen;
+  std::atomic<FreezePolicy> m_freeze_policy;
+
+  // Every index ever built.  Readers may still be using a replaced index,
+  // so we hold on to them until the registry itself goes away.
+  std::vector<std::unique_ptr<FrozenIndex>> m_indices;
+
+  std::atomic_bool m_externally_ticked;
+  std::mutex m_ticker_mutex;
+  std::condition_variable m_ticker_cv;
+  bool m_ticker_running;
+  std::chrono::nanoseconds m_ticker_interval;
+  std::thread m_ticker_thread;
 };
 
 template <typename T, typename Factory>
 std::shared_ptr<T> Registry::get_or_add(
     const std::string& name,
-    std::map<std::string, std::shared_ptr<T>>& collection,
+    MetricType type,
+    Collection<T> collection,
     Factory&& factory)
 {
+  if (SelfMetrics::is_enabled())
+  {
+    SelfMetrics::count(SelfMetrics::Count::RegistryLookups);
+  }
+
+  std::shared_ptr<void> frozen;
+  if (find_frozen(name, type, frozen))
+  {
+    return std::static_pointer_cast<T>(frozen);
+  }
+
+  Shard& shard = shard_for(name);
+  auto& metrics = shard.*collection;
+
   { // scope for RAII shared-read lock
-    std::shared_lock<std::shared_timed_mutex> read_lock(m_mutex);
-    if (m_names.find(name) != m_names.end())
+    std::shared_lock<std::shared_timed_mutex> read_lock(shard.mutex);
+    if (shard.names.find(name) != shard.names.end())
     {
-      return collection[name];
+      auto it = metrics.find(name);
+      return it != metrics.end() ? it->second : nullptr;
     }
   }
 
-  std::unique_lock<std::shared_timed_mutex> lock(m_mutex);
-  if (m_names.find(name) != m_names.end())
+  // Build the metric before taking the exclusive lock; construction
+  // can allocate, and we don't want to stall readers of this shard while
+  // it happens.  If we lose a race to create it, the spare is discarded.
+  std::shared_ptr<T> metric = factory();
+
+  std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+  if (shard.names.find(name) != shard.names.end())
   {
-    return collection[name];
+    auto it = metrics.find(name);
+    return it != metrics.end() ? it->second : nullptr;
   }
   else
   {
-    std::shared_ptr<T> metric = factory();
-    m_names.insert(name);
-    collection[name] = metric;
+    ensure_not_rejecting();
+    insert_locked(shard, collection, name, metric);
+
+    if (SelfMetrics::is_enabled())
+    {
+      SelfMetrics::count(SelfMetrics::Count::RegistryCreations);
+    }
     return metric;
   }
 }
 
+template <typename T, typename Factory>
+std::size_t Registry::add_all(
+    const std::vector<std::string>& names,
+    Collection<T> collection,
+    Factory&& factory)
+{
+  std::vector<std::vector<const std::string*>> by_shard(m_shards.size());
+  for (auto&& name : names)
+  {
+    by_shard[shard_index(name)].push_back(&name);
+  }
+
+  std::size_t added = 0;
+  std::vector<std::pair<const std::string*, std::shared_ptr<T>>> missing;
+  for (std::size_t i = 0; i < m_shards.size(); ++i)
+  {
+    Shard& shard = *m_shards[i];
+
+    missing.clear();
+    { // scope for RAII shared-read lock
+      std::shared_lock<std::shared_timed_mutex> read_lock(shard.mutex);
+      for (const std::string* name : by_shard[i])
+      {
+        if (shard.names.find(*name) == shard.names.end())
+        {
+          missing.emplace_back(name, nullptr);
+        }
+      }
+    }
+
+    if (missing.empty())
+    {
+      continue;
+    }
+
+    // As in get_or_add, build the metrics before taking the exclusive
+    // lock.  Names that turn up in the meantime keep their metric.
+    ensure_not_rejecting();
+    for (auto&& entry : missing)
+    {
+      entry.second = factory();
+    }
+
+    std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+    for (auto&& entry : missing)
+    {
+      if (shard.names.find(*entry.first) == shard.names.end())
+      {
+        ensure_not_rejecting();
+        insert_locked(shard, collection, *entry.first, entry.second);
+        ++added;
+      }
+    }
+  }
+
+  if (SelfMetrics::is_enabled())
+  {
+    SelfMetrics::count(SelfMetrics::Count::RegistryCreations, static_cast<long>(added));
+  }
+  return added;
+}
+
+template <typename T>
+bool Registry::put(const std::string& name, Collection<T> collection, const std::shared_ptr<T>& metric)
+{
+  Shard& shard = shard_for(name);
+
+  std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+  if (shard.names.find(name) != shard.names.end())
+  {
+    return false;
+  }
+
+  ensure_not_rejecting();
+  insert_locked(shard, collection, name, metric);
+  return true;
+}
+
+// Adds a metric whose name is new to |shard|, which must be locked
+// exclusively.  If this throws, the shard is left as it was; a name is
+// never reserved without its metric.
+template <typename T>
+void Registry::insert_locked(Shard& shard, Collection<T> collection, const std::string& name, const std::shared_ptr<T>& metric)
+{
+  auto& metrics = shard.*collection;
+  auto inserted = metrics.emplace(name, metric);
+  try
+  {
+    shard.names.insert(name);
+  }
+  catch (...)
+  {
+    metrics.erase(inserted.first);
+    throw;
+  }
+  on_added(metric);
+}
+
+template <typename T>
+std::map<std::string, std::shared_ptr<T>> Registry::collect(Collection<T> collection)
+{
+  std::map<std::string, std::shared_ptr<T>> result;
+  for (auto&& shard : m_shards)
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(shard->mutex);
+    auto&& metrics = (*shard).*collection;
+    result.insert(metrics.begin(), metrics.end());
+  }
+  return result;
+}
+
 } // namespace cppmetrics
 
 #endif
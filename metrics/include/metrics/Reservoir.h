@@ -29,7 +29,41 @@ public:
 
     virtual std::size_t size() const = 0;
     virtual void update(long value) = 0;
+
+    /**
+     * Adds |n| values at once.  The default just calls |update| for each;
+     * reservoirs override it to take their locks, or read the clock, once
+     * per batch rather than once per value.
+     */
+    virtual void update_batch(const long* values, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            update(values[i]);
+        }
+    }
+
+    /**
+     * Adds |value| as standing for |weight| events, e.g. one event
+     * sampled out of |weight|.  The default records it like any other
+     * value; reservoirs that weight their samples override it.
+     */
+    virtual void update_weighted(long value, double weight)
+    {
+        (void) weight;
+        update(value);
+    }
+
     virtual std::shared_ptr<Snapshot> get_snapshot() = 0;
+
+    /**
+     * The bytes this reservoir occupies, samples included.  Reservoirs
+     * that hold anything beyond the base class should override it.
+     */
+    virtual std::size_t memory_usage() const noexcept
+    {
+        return sizeof(Reservoir);
+    }
 };
 
 }
@@ -0,0 +1,69 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef CPPMETRICS_METRICS_SAMPLEDHISTOGRAM_H
+#define CPPMETRICS_METRICS_SAMPLEDHISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <metrics/LongAdder.h>
+#include <metrics/Reservoir.h>
+#include <metrics/Sampler.h>
+
+namespace cppmetrics {
+
+class Clock;
+class Snapshot;
+
+/**
+ * A Histogram that only records a sample of its values (see Sampler),
+ * for call sites too hot to pay for a reservoir update every time.
+ *
+ * Every value is still counted, exactly; get_count() is the true number
+ * of updates, not the number recorded.  Each recorded value is weighted
+ * by the interval it was sampled at, so that in adaptive mode, busy
+ * periods sampled at a large interval still carry their share of the
+ * snapshot.  That takes a reservoir that honours weights, such as
+ * ExponentiallyDecayingReservoir.
+ */
+class SampledHistogram
+{
+public:
+  SampledHistogram(std::unique_ptr<Reservoir>&& reservoir, std::uint32_t interval);
+  SampledHistogram(std::unique_ptr<Reservoir>&& reservoir,
+                   std::uint32_t initial_interval,
+                   std::uint64_t budget_per_second,
+                   Clock* clock = nullptr);
+
+  void update(long value);
+
+  long get_count() const noexcept;
+  long get_recorded_count() const noexcept;
+  std::uint32_t get_sample_interval() const noexcept;
+  std::shared_ptr<Snapshot> get_snapshot();
+
+  std::size_t memory_usage() const noexcept;
+
+private:
+  Sampler m_sampler;
+  LongAdder m_count;
+  LongAdder m_recorded;
+  std::unique_ptr<Reservoir> m_reservoir;
+};
+
+}
+
+#endif
@@ -0,0 +1,85 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef CPPMETRICS_METRICS_SAMPLEDTIMER_H
+#define CPPMETRICS_METRICS_SAMPLEDTIMER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <metrics/LatencyTimer.h>
+#include <metrics/Reservoir.h>
+#include <metrics/Sampler.h>
+
+namespace cppmetrics {
+
+class Clock;
+class Snapshot;
+
+/**
+ * A LatencyTimer that only records a sample of its durations (see
+ * Sampler).  Every event is counted, so counts and rates are exact;
+ * scopes that aren't sampled don't read the clock at all.  As with
+ * SampledHistogram, durations are weighted by their sampling interval.
+ */
+class SampledTimer
+{
+public:
+  SampledTimer(std::unique_ptr<Reservoir>&& reservoir, std::uint32_t interval, Clock* clock = nullptr);
+  SampledTimer(std::unique_ptr<Reservoir>&& reservoir,
+               std::uint32_t initial_interval,
+               std::uint64_t budget_per_second,
+               Clock* clock = nullptr);
+
+  void update(const std::chrono::nanoseconds& nanos);
+
+  long get_count() const noexcept;
+  std::uint32_t get_sample_interval() const noexcept;
+  double get_m1_rate();
+  double get_m5_rate();
+  double get_m15_rate();
+  double get_mean_rate();
+  std::shared_ptr<Snapshot> get_snapshot();
+
+  std::size_t memory_usage() const noexcept;
+
+  class Scope
+  {
+  public:
+    Scope(SampledTimer& timer);
+    ~Scope();
+
+  private:
+    SampledTimer& m_timer;
+    std::uint32_t m_weight;
+    std::chrono::nanoseconds m_start;
+  };
+
+private:
+  Sampler m_sampler;
+  LatencyTimer m_timer;
+};
+
+template <typename Function>
+auto timed(SampledTimer& timer, Function&& fn) -> decltype(fn())
+{
+  SampledTimer::Scope scope(timer);
+  return fn();
+}
+
+}
+
+#endif
@@ -0,0 +1,87 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef CPPMETRICS_METRICS_SAMPLER_H
+#define CPPMETRICS_METRICS_SAMPLER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace cppmetrics {
+
+class Clock;
+
+/**
+ * Decides which events get recorded by a sampled metric: one in every
+ * |interval|, by way of a thread-local countdown rather than a random
+ * number.
+ *
+ * In adaptive mode, the interval is doubled whenever more than
+ * |budget_per_second| events were sampled in the last second, and halved
+ * again once the sampled rate falls well below budget.  Adapting reads
+ * the clock, but only for events that are sampled.
+ *
+ * Each thread keeps one countdown per live sampler, in a thread-local
+ * table indexed by sampler id and grown on first use.  Ids of destroyed
+ * samplers are reused, so the table only grows with the number of
+ * samplers alive at once; a reused entry starts afresh.
+ */
+class Sampler
+{
+public:
+  static const std::uint32_t kMaxInterval;
+
+  explicit Sampler(std::uint32_t interval);
+  Sampler(std::uint32_t initial_interval, std::uint64_t budget_per_second, Clock* clock = nullptr);
+
+  ~Sampler();
+
+  Sampler(const Sampler&) = delete;
+  Sampler& operator=(const Sampler&) = delete;
+
+  /**
+   * Returns true if the current event should be recorded.
+   */
+  bool should_sample() noexcept;
+
+  /**
+   * Like should_sample(), but returns the recorded event's weight - the
+   * interval in force when it was sampled - or zero if it should not be
+   * recorded.
+   */
+  std::uint32_t sample() noexcept;
+
+  std::uint32_t get_interval() const noexcept;
+  bool is_adaptive() const noexcept;
+
+private:
+  void adapt() noexcept;
+  std::uint32_t& countdown() noexcept;
+  std::uint32_t& grow_countdowns() noexcept;
+
+private:
+  std::size_t m_id;
+  std::uint64_t m_owner;
+  std::atomic<std::uint32_t> m_interval;
+
+  std::uint64_t m_budget;
+  Clock* m_clock;
+  std::atomic<std::int64_t> m_window_start;
+  std::atomic<std::uint64_t> m_window_samples;
+};
+
+}
+
+#endif
@@ -0,0 +1,124 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef CPPMETRICS_SELFMETRICS_H
+#define CPPMETRICS_SELFMETRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <metrics/ClockPolicy.h>
+
+namespace cppmetrics {
+
+class Clock;
+class Counter;
+
+/**
+ * Metrics describing the library's own overhead, collected process-wide
+ * once enabled; Registry::enable_self_metrics is the usual way in.
+ *
+ * Instrumented paths check is_enabled() first, so while disabled each
+ * costs one relaxed load.  When enabled, LongAdder and the reservoirs
+ * still only pay on their slow branches: failed CASes and rehashes are
+ * counted as they happen, and lock waits are timed only when the lock is
+ * contended.  Registry lookups are the exception; each one costs about
+ * a Counter::inc more while self metrics are on.
+ *
+ * The metrics do not count themselves: anything recorded while recording
+ * a self metric is dropped.
+ */
+class SelfMetrics
+{
+public:
+  enum class Count
+  {
+    CasFailures,
+    Rehashes,
+    RegistryLookups,
+    RegistryCreations,
+  };
+
+  enum class Duration
+  {
+    ReporterPass,
+    SnapshotBuild,
+    ReservoirRescale,
+    ReservoirLockWait,
+  };
+
+  static bool is_enabled() noexcept
+  {
+    return s_enabled.load(std::memory_order_relaxed);
+  }
+
+  static void set_enabled(bool enabled) noexcept;
+
+  /**
+   * Sets the clock behind the self timers' reservoirs and rates.  Only
+   * effective before self metrics are first enabled; meant for tests.
+   */
+  static void set_clock(Clock* clock) noexcept;
+
+  static void count(Count which, long n = 1) noexcept;
+  static void record(Duration which, const std::chrono::nanoseconds& elapsed) noexcept;
+
+  /**
+   * Every self metric, with its name, e.g. "registry.lookups".
+   */
+  static std::vector<std::pair<std::string, std::shared_ptr<Counter>>> get_counters();
+  static std::vector<std::pair<std::string, std::shared_ptr<Timer>>> get_timers();
+
+  /**
+   * Times its own lifetime into a Duration, if self metrics were enabled
+   * when it began.
+   */
+  class Scope
+  {
+  public:
+    explicit Scope(Duration which) noexcept
+      : m_which(which)
+      , m_running(is_enabled())
+      , m_start(m_running ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point())
+    {}
+
+    ~Scope()
+    {
+      if (m_running)
+      {
+        record(m_which, std::chrono::steady_clock::now() - m_start);
+      }
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    Duration m_which;
+    bool m_running;
+    std::chrono::steady_clock::time_point m_start;
+  };
+
+private:
+  static std::atomic_bool s_enabled;
+  static std::atomic<Clock*> s_clock;
+};
+
+}
+
+#endif
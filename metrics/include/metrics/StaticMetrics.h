@@ -0,0 +1,137 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef CPPMETRICS_METRICS_STATICMETRICS_H
+#define CPPMETRICS_METRICS_STATICMETRICS_H
+
+#include <memory>
+#include <utility>
+
+#include <metrics/Counter.h>
+#include <metrics/ExponentiallyDecayingReservoir.h>
+#include <metrics/Gauge.h>
+#include <metrics/Histogram.h>
+#include <metrics/Meter.h>
+#include <metrics/Registry.h>
+#include <metrics/Timer.h>
+
+namespace cppmetrics {
+
+/**
+ * A node in the process-wide list of statically-declared metrics.
+ *
+ * Static metrics link themselves into a lock-free, intrusive list as they
+ * are constructed during static initialization.  The list head is constant-
+ * initialized, so it is safe to use from any translation unit regardless of
+ * initialization order.  Nodes are never unlinked.
+ *
+ * See Registry::register_static_metrics.
+ */
+class StaticMetricBase
+{
+public:
+  virtual ~StaticMetricBase() = default;
+
+  const char* name() const noexcept
+  {
+    return m_name;
+  }
+
+  StaticMetricBase* next() const noexcept
+  {
+    return m_next;
+  }
+
+  static StaticMetricBase* head() noexcept;
+
+  virtual bool register_with(Registry& registry) = 0;
+
+protected:
+  explicit StaticMetricBase(const char* name) noexcept
+      : m_name(name)
+      , m_next(nullptr)
+  {}
+
+  void link() noexcept;
+
+private:
+  const char* m_name;
+  StaticMetricBase* m_next;
+};
+
+/**
+ * A metric with static storage duration.
+ *
+ * A StaticMetric *is* its metric, so using one is a direct call on a global
+ * object, with no registry lookup and no shared_ptr indirection.  When
+ * registered, the registry holds a non-owning shared_ptr to it; static
+ * metrics must therefore outlive any registry they are registered with.
+ */
+template <typename T>
+class StaticMetric : public T, public StaticMetricBase
+{
+public:
+  template <typename ...Args>
+  explicit StaticMetric(const char* name, Args&& ...args)
+      : T(std::forward<Args>(args)...)
+      , StaticMetricBase(name)
+  {
+    link();
+  }
+
+  T& metric() noexcept
+  {
+    return *this;
+  }
+
+  bool register_with(Registry& registry) override
+  {
+    // Aliasing constructor: no control block, and nothing is ever deleted.
+    return registry.add(name(), std::shared_ptr<T>(std::shared_ptr<T>(), this));
+  }
+};
+
+using StaticGauge     = StaticMetric<Gauge>;
+using StaticCounter   = StaticMetric<Counter>;
+using StaticMeter     = StaticMetric<Meter>;
+using StaticHistogram = StaticMetric<Histogram>;
+using StaticTimer     = StaticMetric<Timer>;
+
+}
+
+/**
+ * Declares (CPPMETRICS_DECLARE_*) or defines (CPPMETRICS_*) a static metric
+ * at namespace scope.  The plain forms use the identifier as the metric name;
+ * the _NAMED forms accept any string, e.g. "http.requests".
+ */
+#define CPPMETRICS_DECLARE_GAUGE(id)     extern ::cppmetrics::StaticGauge id
+#define CPPMETRICS_DECLARE_COUNTER(id)   extern ::cppmetrics::StaticCounter id
+#define CPPMETRICS_DECLARE_METER(id)     extern ::cppmetrics::StaticMeter id
+#define CPPMETRICS_DECLARE_HISTOGRAM(id) extern ::cppmetrics::StaticHistogram id
+#define CPPMETRICS_DECLARE_TIMER(id)     extern ::cppmetrics::StaticTimer id
+
+#define CPPMETRICS_GAUGE_NAMED(id, name)   ::cppmetrics::StaticGauge id{name}
+#define CPPMETRICS_COUNTER_NAMED(id, name) ::cppmetrics::StaticCounter id{name}
+#define CPPMETRICS_METER_NAMED(id, name)   ::cppmetrics::StaticMeter id{name}
+#define CPPMETRICS_HISTOGRAM_NAMED(id, name) \
+  ::cppmetrics::StaticHistogram id{name, std::make_unique<::cppmetrics::ExponentiallyDecayingReservoir>()}
+#define CPPMETRICS_TIMER_NAMED(id, name)   ::cppmetrics::StaticTimer id{name}
+
+#define CPPMETRICS_GAUGE(id)     CPPMETRICS_GAUGE_NAMED(id, #id)
+#define CPPMETRICS_COUNTER(id)   CPPMETRICS_COUNTER_NAMED(id, #id)
+#define CPPMETRICS_METER(id)     CPPMETRICS_METER_NAMED(id, #id)
+#define CPPMETRICS_HISTOGRAM(id) CPPMETRICS_HISTOGRAM_NAMED(id, #id)
+#define CPPMETRICS_TIMER(id)     CPPMETRICS_TIMER_NAMED(id, #id)
+
+#endif
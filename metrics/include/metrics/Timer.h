@@ -16,9 +16,14 @@
 #define CPPMETRICS_METRICS_TIMER_H
 
 #include <chrono>
+#include <cstddef>
 #include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <metrics/Clock.h>
+#include <metrics/ClockPolicy.h>
 #include <metrics/Histogram.h>
 #include <metrics/Meter.h>
 #include <metrics/Reservoir.h>
@@ -27,17 +32,46 @@ namespace cppmetrics {
 
 class Snapshot;
 
-class Timer
+template <typename ClockPolicy>
+class BasicScopeTimer;
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+template <typename ClockPolicy, typename Awaitable>
+class TimedAwaiter;
+#endif
+
+/**
+ * Times scopes, keeping their durations in a histogram and their rate in
+ * a meter.
+ *
+ * As with BasicMeter, the clock is a compile-time policy: Timer reads it
+ * through a Clock*, while SteadyTimer reads steady_clock inline.
+ */
+template <typename ClockPolicy>
+class BasicTimer
 {
 public:
-  Timer();
-  Timer(std::unique_ptr<Reservoir>&& reservoir);
-  Timer(std::unique_ptr<Reservoir>&& reservoir, Clock* clock);
-  Timer(Timer&&) = default;
+  BasicTimer();
+  BasicTimer(std::unique_ptr<Reservoir>&& reservoir);
+  BasicTimer(std::unique_ptr<Reservoir>&& reservoir, ClockPolicy clock);
+
+  /**
+   * Times scopes with |clock|, but ticks the rates with |rate_clock|,
+   * which can be a cheaper, coarser one such as GetCoarseClock().
+   */
+  BasicTimer(std::unique_ptr<Reservoir>&& reservoir, ClockPolicy clock, ClockPolicy rate_clock);
+  BasicTimer(BasicTimer&&) = default;
 
   void update(const std::chrono::nanoseconds& nanos);
   void update(const std::chrono::milliseconds& millis);
 
+  /**
+   * Records |n| durations, in nanoseconds, marking the meter once and
+   * updating the reservoir in one batch.  Negative durations are dropped,
+   * as with |update|.
+   */
+  void update_batch(const long* nanos, std::size_t n);
+
   long get_count();
   double get_m1_rate();
   double get_m5_rate();
@@ -45,41 +79,218 @@ public:
   double get_mean_rate();
   std::shared_ptr<Snapshot> get_snapshot();
 
+  Epoch::value_t last_update_epoch() const noexcept;
+
+  std::size_t memory_usage() const noexcept;
+
+  /**
+   * A stopwatch for work that doesn't fit in one scope: it can be moved
+   * to another thread, or into a callback, and is stopped exactly once -
+   * either explicitly, or when it is destroyed.  Moved-from contexts are
+   * inert.  Like ScopeTimer, it costs one clock read at each end.
+   */
+  class Context
+  {
+  public:
+    Context(Context&& other) noexcept
+        : m_timer(other.m_timer)
+        , m_start(other.m_start)
+    {
+      other.m_timer = nullptr;
+    }
+
+    Context& operator=(Context&& other) noexcept
+    {
+      if (this != &other)
+      {
+        stop();
+        m_timer = other.m_timer;
+        m_start = other.m_start;
+        other.m_timer = nullptr;
+      }
+      return *this;
+    }
+
+    Context(const Context&) = delete;
+    Context& operator=(const Context&) = delete;
+
+    ~Context()
+    {
+      stop();
+    }
+
+    /**
+     * Records the time elapsed since the context was started, and returns
+     * it.  Returns zero, and records nothing, if already stopped.
+     */
+    std::chrono::nanoseconds stop()
+    {
+      if (m_timer == nullptr)
+      {
+        return std::chrono::nanoseconds::zero();
+      }
+
+      auto timer = m_timer;
+      m_timer = nullptr;
+
+      auto elapsed = timer->m_clock.tick() - m_start;
+      timer->update(elapsed);
+      return elapsed;
+    }
+
+    bool is_running() const noexcept
+    {
+      return m_timer != nullptr;
+    }
+
+  private:
+    friend class BasicTimer;
+
+    explicit Context(BasicTimer& timer)
+        : m_timer(&timer)
+        , m_start(timer.m_clock.tick())
+    {}
+
+    BasicTimer* m_timer;
+    std::chrono::nanoseconds m_start;
+  };
+
+  /**
+   * Starts a Context, timing until it is stopped.
+   */
+  Context time()
+  {
+    return Context(*this);
+  }
+
 private:
-  friend class ScopeTimer;
+  friend class Registry;
+  friend class BasicScopeTimer<ClockPolicy>;
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+  template <typename, typename> friend class TimedAwaiter;
+#endif
 
-  Clock* m_clock;
+  ClockPolicy m_clock;
   Histogram m_histogram;
-  Meter m_meter;
+  BasicMeter<ClockPolicy> m_meter;
 };
 
-class ScopeTimer
+extern template class BasicTimer<ClockRef>;
+extern template class BasicTimer<SteadyClockPolicy>;
+
+template <typename ClockPolicy>
+class BasicScopeTimer
 {
 public:
-  ScopeTimer(Timer& timer)
+  BasicScopeTimer(BasicTimer<ClockPolicy>& timer)
       : m_timer(timer)
-      , m_start(m_timer.m_clock->tick())
+      , m_start(m_timer.m_clock.tick())
   {
   }
 
-  ~ScopeTimer()
+  ~BasicScopeTimer()
   {
-    auto elapsed = m_timer.m_clock->tick() - m_start;
+    auto elapsed = m_timer.m_clock.tick() - m_start;
     m_timer.update(elapsed);
   }
 
 private:
-  Timer& m_timer;
+  BasicTimer<ClockPolicy>& m_timer;
   std::chrono::nanoseconds m_start;
 };
 
-template <typename Function>
-auto timed(Timer& timer, Function&& fn) -> decltype(fn())
+using ScopeTimer = BasicScopeTimer<ClockRef>;
+using SteadyScopeTimer = BasicScopeTimer<SteadyClockPolicy>;
+
+template <typename ClockPolicy, typename Function>
+auto timed(BasicTimer<ClockPolicy>& timer, Function&& fn) -> decltype(fn())
 {
-  ScopeTimer scopeTimer(timer);
+  BasicScopeTimer<ClockPolicy> scopeTimer(timer);
   return fn();
 }
 
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+/**
+ * Finds the awaiter that co_await would use for |awaitable|: the result
+ * of its operator co_await, member or free, or else the awaitable itself.
+ */
+template <typename Awaitable>
+decltype(auto) get_awaiter(Awaitable&& awaitable)
+{
+  if constexpr (requires { std::forward<Awaitable>(awaitable).operator co_await(); })
+  {
+    return std::forward<Awaitable>(awaitable).operator co_await();
+  }
+  else if constexpr (requires { operator co_await(std::forward<Awaitable>(awaitable)); })
+  {
+    return operator co_await(std::forward<Awaitable>(awaitable));
+  }
+  else
+  {
+    return std::forward<Awaitable>(awaitable);
+  }
+}
+
+/**
+ * Wraps an awaitable so that the time from the co_await until the
+ * coroutine resumes is recorded in a timer:
+ *
+ *   auto result = co_await timed_await(timer, socket.async_read(...));
+ *
+ * Timing starts when the co_await does, not when the wrapper is made.  A
+ * coroutine destroyed while suspended records nothing.
+ */
+template <typename ClockPolicy, typename Awaitable>
+class TimedAwaiter
+{
+  using AwaiterResult = decltype(get_awaiter(std::declval<Awaitable>()));
+
+  // An awaitable that is its own awaiter is held as timed_await got it:
+  // by reference if it was an lvalue, moved in if it was not.
+  using Awaiter = std::conditional_t<std::is_rvalue_reference<AwaiterResult>::value,
+                                     std::remove_reference_t<AwaiterResult>,
+                                     AwaiterResult>;
+
+public:
+  TimedAwaiter(BasicTimer<ClockPolicy>& timer, Awaitable&& awaitable)
+      : m_timer(timer)
+      , m_awaiter(get_awaiter(std::forward<Awaitable>(awaitable)))
+      , m_start(0)
+  {}
+
+  bool await_ready()
+  {
+    m_start = m_timer.m_clock.tick();
+    return m_awaiter.await_ready();
+  }
+
+  template <typename Handle>
+  decltype(auto) await_suspend(Handle handle)
+  {
+    return m_awaiter.await_suspend(handle);
+  }
+
+  decltype(auto) await_resume()
+  {
+    m_timer.update(m_timer.m_clock.tick() - m_start);
+    return m_awaiter.await_resume();
+  }
+
+private:
+  BasicTimer<ClockPolicy>& m_timer;
+  Awaiter m_awaiter;
+  std::chrono::nanoseconds m_start;
+};
+
+template <typename ClockPolicy, typename Awaitable>
+TimedAwaiter<ClockPolicy, Awaitable> timed_await(BasicTimer<ClockPolicy>& timer, Awaitable&& awaitable)
+{
+  return TimedAwaiter<ClockPolicy, Awaitable>(timer, std::forward<Awaitable>(awaitable));
+}
+
+#endif
+
 }
 
 #endif
@@ -0,0 +1,93 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef CPPMETRICS_METRICS_TSCCLOCK_H
+#define CPPMETRICS_METRICS_TSCCLOCK_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include <metrics/Clock.h>
+
+namespace cppmetrics {
+
+/**
+ * A Clock that reads the CPU's timestamp counter (rdtsc on x86, cntvct
+ * on ARM) instead of going through the OS.
+ *
+ * The counter is calibrated against CLOCK_MONOTONIC at construction,
+ * and re-calibrated every |recalibration_interval| thereafter; drift
+ * between calibrations is slewed out rather than stepped, so the clock
+ * never goes backwards.
+ *
+ * On CPUs without an invariant counter (i.e. one that keeps a constant
+ * rate across frequency changes and sleep states), tick() falls back to
+ * clock_gettime(CLOCK_MONOTONIC).
+ *
+ * Ticks are nanoseconds since an unspecified epoch; now_as_time_t()
+ * still reports wall-clock time.
+ */
+class TscClock : public Clock
+{
+public:
+  explicit TscClock(const std::chrono::nanoseconds& recalibration_interval = std::chrono::seconds(1));
+
+  std::chrono::nanoseconds tick() override;
+
+  /**
+   * Returns true if this machine has a usable invariant counter.
+   */
+  static bool is_supported() noexcept;
+
+private:
+  void calibrate();
+  void recalibrate(std::int64_t ticks);
+
+  struct Calibration
+  {
+    std::int64_t ticks;
+    std::int64_t nanos;
+    double nanos_per_tick;
+  };
+
+  Calibration load_calibration() const noexcept;
+  void store_calibration(const Calibration& calibration) noexcept;
+
+private:
+  bool m_supported;
+  std::chrono::nanoseconds m_recalibration_interval;
+
+  // The very first sample; rates are measured from here, so that they
+  // grow more accurate the longer the clock lives.
+  std::int64_t m_anchor_ticks;
+  std::int64_t m_anchor_nanos;
+
+  // A seqlock around the current calibration.  Odd while it is being
+  // written; readers retry until they see the same even value twice.
+  std::atomic<std::uint32_t> m_sequence;
+  std::atomic<std::int64_t> m_base_ticks;
+  std::atomic<std::int64_t> m_base_nanos;
+  std::atomic<double> m_nanos_per_tick;
+  std::atomic<std::int64_t> m_next_recalibration;
+};
+
+/**
+ * Returns a shared TscClock, calibrated on first use.
+ */
+Clock* GetTscClock();
+
+}
+
+#endif
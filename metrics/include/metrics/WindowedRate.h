@@ -0,0 +1,90 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef CPPMETRICS_METRICS_WINDOWEDRATE_H
+#define CPPMETRICS_METRICS_WINDOWEDRATE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <metrics/LongAdder.h>
+
+namespace cppmetrics {
+
+class Clock;
+
+/**
+ * A rate over a sliding window of whole seconds.
+ *
+ * Unlike a Meter's exponentially-weighted averages, the rate reported
+ * here is exact: it is the number of marks in the last N complete
+ * seconds, divided by N, for any N up to the configured horizon.
+ *
+ * Marks go to a single striped counter.  Whenever the clock crosses a
+ * second boundary, the running total is recorded in a ring with one
+ * slot per second, so any rate is the difference of two slots - O(1)
+ * regardless of the window.
+ */
+class WindowedRate
+{
+public:
+  explicit WindowedRate(const std::chrono::seconds& horizon = std::chrono::seconds(60), Clock* clock = nullptr);
+
+  void mark(long n = 1);
+
+  long get_count() const noexcept;
+
+  /**
+   * Returns the per-second rate over the last |window| complete seconds.
+   *
+   * @throws std::invalid_argument if |window| is zero or exceeds the horizon.
+   */
+  double get_rate(const std::chrono::seconds& window);
+
+  /**
+   * Returns the per-second rate over the whole horizon.
+   */
+  double get_rate();
+
+  std::chrono::seconds get_horizon() const noexcept;
+
+  std::size_t memory_usage() const noexcept;
+
+private:
+  void rotate_if_necessary();
+
+  std::atomic<LongAdder::value_t>& slot(std::int64_t second) noexcept;
+
+private:
+  Clock* m_clock;
+  std::int64_t m_horizon;
+  std::int64_t m_slot_count;
+  LongAdder m_total;
+  std::atomic<std::int64_t> m_current_second;
+
+  // The newest second whose snapshot has been written; readers go by
+  // this rather than m_current_second, which is claimed before writing,
+  // and retry if the two differ.
+  std::atomic<std::int64_t> m_published_second;
+
+  // m_snapshots[s % m_slot_count] is the total as of the start of second s.
+  std::unique_ptr<std::atomic<LongAdder::value_t>[]> m_snapshots;
+};
+
+}
+
+#endif
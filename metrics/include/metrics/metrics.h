@@ -15,12 +15,25 @@
 #ifndef CPPMETRICS_METRICS_METRICS_H
 #define CPPMETRICS_METRICS_METRICS_H
 
+#include <metrics/CachedGauge.h>
+#include <metrics/CallbackGauge.h>
+#include <metrics/CoarseClock.h>
 #include <metrics/Counter.h>
+#include <metrics/DerivativeGauge.h>
+#include <metrics/DoubleGauge.h>
 #include <metrics/Gauge.h>
 #include <metrics/Meter.h>
 #include <metrics/Histogram.h>
+#include <metrics/LatencyTimer.h>
+#include <metrics/RatioGauge.h>
+#include <metrics/SampledHistogram.h>
+#include <metrics/SampledTimer.h>
+#include <metrics/SelfMetrics.h>
 #include <metrics/Snapshot.h>
+#include <metrics/StaticMetrics.h>
 #include <metrics/Timer.h>
+#include <metrics/TscClock.h>
 #include <metrics/Registry.h>
+#include <metrics/WindowedRate.h>
 
 #endif
@@ -0,0 +1,66 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/CachedGauge.h>
+
+#include <utility>
+
+#include <metrics/Clock.h>
+
+namespace cppmetrics {
+
+CachedGauge::CachedGauge(std::function<long()> fn, const std::chrono::nanoseconds& ttl, Clock* clock)
+    : m_fn(std::move(fn))
+    , m_ttl(ttl)
+    , m_clock(clock != nullptr ? clock : GetDefaultClock())
+    , m_mutex()
+    , m_cached(0)
+    , m_valid(false)
+    , m_expires_at(0)
+{}
+
+long CachedGauge::get()
+{
+  auto now = m_clock->tick().count();
+  if (m_valid.load(std::memory_order_acquire) && now < m_expires_at.load(std::memory_order_relaxed))
+  {
+    return m_cached.load(std::memory_order_relaxed);
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  // Someone else may have refreshed it while we waited.
+  if (m_valid.load(std::memory_order_relaxed) && now < m_expires_at.load(std::memory_order_relaxed))
+  {
+    return m_cached.load(std::memory_order_relaxed);
+  }
+
+  auto value = m_fn();
+  m_cached.store(value, std::memory_order_relaxed);
+  m_expires_at.store(now + m_ttl.count(), std::memory_order_relaxed);
+  m_valid.store(true, std::memory_order_release);
+  return value;
+}
+
+Epoch::value_t CachedGauge::last_update_epoch() const noexcept
+{
+  return Epoch::current();
+}
+
+std::size_t CachedGauge::memory_usage() const noexcept
+{
+  return sizeof(CachedGauge);
+}
+
+}
@@ -0,0 +1,40 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/CallbackGauge.h>
+
+#include <utility>
+
+namespace cppmetrics {
+
+CallbackGauge::CallbackGauge(std::function<long()> fn)
+    : m_fn(std::move(fn))
+{}
+
+long CallbackGauge::get()
+{
+  return m_fn();
+}
+
+Epoch::value_t CallbackGauge::last_update_epoch() const noexcept
+{
+  return Epoch::current();
+}
+
+std::size_t CallbackGauge::memory_usage() const noexcept
+{
+  return sizeof(CallbackGauge);
+}
+
+}
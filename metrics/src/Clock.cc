@@ -16,15 +16,11 @@
 
 namespace cppmetrics {
 
-namespace {
-
-Clock* gDefaultClock = new Clock;
-
-}
-
 std::chrono::nanoseconds Clock::tick()
 {
-  auto now = std::chrono::system_clock::now();
+  // Monotonic, so that NTP slewing and steps can't make durations
+  // negative or throw off rates.  Only now_as_time_t is wall time.
+  auto now = std::chrono::steady_clock::now();
   return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch());
 }
 
@@ -36,6 +32,9 @@ time_t Clock::now_as_time_t()
 
 Clock* GetDefaultClock()
 {
+  // Function-local, so that metrics with static storage duration
+  // can safely use it during their own initialization.
+  static Clock* gDefaultClock = new Clock;
   return gDefaultClock;
 }
 
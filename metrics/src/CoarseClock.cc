@@ -0,0 +1,81 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/CoarseClock.h>
+
+namespace cppmetrics {
+
+CoarseClock::CoarseClock(Clock* source, const std::chrono::nanoseconds& resolution)
+    : m_source(source != nullptr ? source : GetDefaultClock())
+    , m_resolution(resolution)
+    , m_tick(0)
+    , m_time(0)
+    , m_mutex()
+    , m_cv()
+    , m_running(true)
+    , m_thread()
+{
+  refresh();
+  m_thread = std::thread([this]() { loop_refreshing(); });
+}
+
+CoarseClock::~CoarseClock()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+  }
+  m_cv.notify_all();
+  m_thread.join();
+}
+
+std::chrono::nanoseconds CoarseClock::tick()
+{
+  return std::chrono::nanoseconds(m_tick.load(std::memory_order_relaxed));
+}
+
+time_t CoarseClock::now_as_time_t()
+{
+  return m_time.load(std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds CoarseClock::get_resolution() const noexcept
+{
+  return m_resolution;
+}
+
+void CoarseClock::refresh()
+{
+  m_tick.store(m_source->tick().count(), std::memory_order_relaxed);
+  m_time.store(m_source->now_as_time_t(), std::memory_order_relaxed);
+}
+
+void CoarseClock::loop_refreshing()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (!m_cv.wait_for(lock, m_resolution, [this]() { return !m_running; }))
+  {
+    refresh();
+  }
+}
+
+Clock* GetCoarseClock()
+{
+  // Never destroyed, so that its thread outlives any static metric
+  // still reading from it during shutdown.
+  static Clock* gCoarseClock = new CoarseClock;
+  return gCoarseClock;
+}
+
+}
@@ -14,6 +14,8 @@
 
 #include <metrics/Counter.h>
 
+#include "MemoryUsage.h"
+
 namespace cppmetrics {
 
 Counter::Counter()
@@ -50,11 +52,13 @@ Counter& Counter::operator=(Counter&& other)
 
 void Counter::inc(value_t n)
 {
+  m_stamp.touch();
   m_adder.incr(n);
 }
 
 void Counter::dec(value_t n)
 {
+  m_stamp.touch();
   m_adder.decr(n);
 }
 
@@ -63,4 +67,14 @@ Counter::value_t Counter::get_count() const noexcept
   return m_adder.count();
 }
 
+Epoch::value_t Counter::last_update_epoch() const noexcept
+{
+  return m_stamp.get();
+}
+
+std::size_t Counter::memory_usage() const noexcept
+{
+  return sizeof(Counter) + MemoryUsage::Owned(m_adder);
+}
+
 }
@@ -0,0 +1,67 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/DerivativeGauge.h>
+
+#include <utility>
+
+#include <metrics/Clock.h>
+#include <metrics/Counter.h>
+
+namespace cppmetrics {
+
+DerivativeGauge::DerivativeGauge(std::function<double()> source, Clock* clock)
+    : m_source(std::move(source))
+    , m_clock(clock != nullptr ? clock : GetDefaultClock())
+    , m_mutex()
+    , m_has_previous(false)
+    , m_previous_value(0.0)
+    , m_previous_time(0)
+{}
+
+DerivativeGauge::DerivativeGauge(std::shared_ptr<Counter> counter, Clock* clock)
+    : DerivativeGauge([counter]() { return static_cast<double>(counter->get_count()); }, clock)
+{}
+
+double DerivativeGauge::get()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto now = m_clock->tick();
+  auto value = m_source();
+
+  double rate = 0.0;
+  if (m_has_previous && now > m_previous_time)
+  {
+    auto elapsed = std::chrono::duration<double>(now - m_previous_time);
+    rate = (value - m_previous_value) / elapsed.count();
+  }
+
+  m_has_previous = true;
+  m_previous_value = value;
+  m_previous_time = now;
+  return rate;
+}
+
+Epoch::value_t DerivativeGauge::last_update_epoch() const noexcept
+{
+  return Epoch::current();
+}
+
+std::size_t DerivativeGauge::memory_usage() const noexcept
+{
+  return sizeof(DerivativeGauge);
+}
+
+}
@@ -0,0 +1,45 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/DoubleGauge.h>
+
+namespace cppmetrics {
+
+DoubleGauge::DoubleGauge()
+    : m_value(0.0)
+    , m_stamp()
+{}
+
+void DoubleGauge::set(double value)
+{
+  m_stamp.touch();
+  m_value.store(value);
+}
+
+double DoubleGauge::get()
+{
+  return m_value.load();
+}
+
+Epoch::value_t DoubleGauge::last_update_epoch() const noexcept
+{
+  return m_stamp.get();
+}
+
+std::size_t DoubleGauge::memory_usage() const noexcept
+{
+  return sizeof(DoubleGauge);
+}
+
+}
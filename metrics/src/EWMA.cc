@@ -20,28 +20,28 @@ namespace cppmetrics {
 
 namespace {
 
-const int kTickIntervalInSeconds = 5;
-const std::chrono::system_clock::duration kTickInterval = std::chrono::seconds{kTickIntervalInSeconds};
-
-const double kAlphaM1  = 1 - exp(-kTickIntervalInSeconds / 60.0 / 1);
-const double kAlphaM5  = 1 - exp(-kTickIntervalInSeconds / 60.0 / 5);
-const double kAlphaM15 = 1 - exp(-kTickIntervalInSeconds / 60.0 / 15);
+constexpr const std::chrono::seconds kTickInterval{5};
 
 }
 
 std::shared_ptr<EWMA> EWMA::one_minute()
 {
-  return std::make_shared<EWMA>(kAlphaM1, kTickInterval);
+  return std::make_shared<EWMA>(alpha_for(std::chrono::minutes{1}, kTickInterval), kTickInterval);
 }
 
 std::shared_ptr<EWMA> EWMA::five_minutes()
 {
-  return std::make_shared<EWMA>(kAlphaM5, kTickInterval);
+  return std::make_shared<EWMA>(alpha_for(std::chrono::minutes{5}, kTickInterval), kTickInterval);
 }
 
 std::shared_ptr<EWMA> EWMA::fifteen_minutes()
 {
-  return std::make_shared<EWMA>(kAlphaM15, kTickInterval);
+  return std::make_shared<EWMA>(alpha_for(std::chrono::minutes{15}, kTickInterval), kTickInterval);
+}
+
+double EWMA::alpha_for(const std::chrono::nanoseconds& window, const std::chrono::nanoseconds& tick_interval)
+{
+  return 1 - exp(-static_cast<double>(tick_interval.count()) / window.count());
 }
 
 EWMA::EWMA(double alpha, const std::chrono::system_clock::duration& tick_interval)
@@ -52,6 +52,14 @@ EWMA::EWMA(double alpha, const std::chrono::system_clock::duration& tick_interva
     , m_alpha(alpha)
 {}
 
+EWMA::EWMA(EWMA&& other) noexcept
+    : m_initialized(other.m_initialized.load())
+    , m_counter(other.m_counter.load())
+    , m_interval(other.m_interval)
+    , m_rate(other.m_rate.load())
+    , m_alpha(other.m_alpha)
+{}
+
 void EWMA::update(long n)
 {
   m_counter += n;
@@ -73,6 +81,50 @@ void EWMA::tick()
   }
 }
 
+void EWMA::tick_n(std::uint64_t ticks)
+{
+  if (ticks == 0)
+  {
+    return;
+  }
+
+  tick();
+
+  if (ticks > 1)
+  {
+    // Each subsequent tick sees an instant rate of zero, so
+    // r' = r + alpha * (0 - r) = r * (1 - alpha).
+    double decay = std::pow(1.0 - m_alpha, static_cast<double>(ticks - 1));
+    m_rate = m_rate.load() * decay;
+  }
+}
+
+void EWMA::tick_spread(long count, std::uint64_t ticks)
+{
+  if (ticks == 0)
+  {
+    update(count);
+    return;
+  }
+
+  count += m_counter.exchange(0);
+  double instant_rate = static_cast<double>(count) / (m_interval.count() * static_cast<double>(ticks));
+  if (m_initialized.load())
+  {
+    // With the same instant rate every tick, the rate approaches it
+    // geometrically: r_k = in + (r_0 - in) * (1 - alpha)^k.
+    double decay = std::pow(1.0 - m_alpha, static_cast<double>(ticks));
+    m_rate = instant_rate + (m_rate.load() - instant_rate) * decay;
+  }
+  else
+  {
+    // The first tick starts the rate at the instant rate, and the rest
+    // leave it there.
+    m_rate = instant_rate;
+    m_initialized = true;
+  }
+}
+
 double EWMA::get_rate(const std::chrono::duration<long>& period)
 {
   return m_rate * std::chrono::duration_cast<std::chrono::nanoseconds>(period).count();
@@ -0,0 +1,26 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/Epoch.h>
+
+namespace cppmetrics {
+
+std::atomic<Epoch::value_t> Epoch::s_current{0};
+
+Epoch::value_t Epoch::advance() noexcept
+{
+  return s_current.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+}
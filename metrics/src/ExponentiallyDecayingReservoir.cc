@@ -24,6 +24,7 @@
 #include <unordered_set>
 
 #include <metrics/Clock.h>
+#include <metrics/SelfMetrics.h>
 
 using namespace std::chrono_literals;
 
@@ -35,6 +36,57 @@ using namespace std::chrono;
 
 constexpr const std::time_t kRescalePeriod = static_cast<std::time_t>(60); // seconds
 
+// Priorities only depend on elapsed time, so this uses the monotonic
+// tick rather than wall time; a clock step can't force a rescale.
+inline std::time_t SecondsNow(Clock* clock)
+{
+  return static_cast<std::time_t>(duration_cast<seconds>(clock->tick()).count());
+}
+
+// Holds |mutex|, timing the wait for it when self metrics are on;
+// uncontended acquisitions never read the clock.  Recording updates a
+// reservoir - possibly this one - so the wait is only recorded once the
+// lock has been released.
+class TimedLock
+{
+public:
+  explicit TimedLock(std::mutex& mutex)
+    : m_mutex(mutex)
+    , m_timed(false)
+    , m_waited(0)
+  {
+    if (m_mutex.try_lock())
+    {
+      return;
+    }
+
+    m_timed = SelfMetrics::is_enabled();
+    auto start = m_timed ? steady_clock::now() : steady_clock::time_point();
+    m_mutex.lock();
+    if (m_timed)
+    {
+      m_waited = steady_clock::now() - start;
+    }
+  }
+
+  ~TimedLock()
+  {
+    m_mutex.unlock();
+    if (m_timed)
+    {
+      SelfMetrics::record(SelfMetrics::Duration::ReservoirLockWait, m_waited);
+    }
+  }
+
+  TimedLock(const TimedLock&) = delete;
+  TimedLock& operator=(const TimedLock&) = delete;
+
+private:
+  std::mutex& m_mutex;
+  bool m_timed;
+  nanoseconds m_waited;
+};
+
 inline bool HasEquivalentOrder(double lhs, double rhs)
 {
   return !(lhs < rhs) && !(rhs < lhs);
@@ -52,7 +104,7 @@ ExponentiallyDecayingReservoir::ExponentiallyDecayingReservoir(std::size_t size,
     : m_mutex()
     , m_count(0)
     , m_clock(clock != nullptr ? clock : GetDefaultClock())
-    , m_start(m_clock->now_as_time_t())
+    , m_start(SecondsNow(m_clock))
     , m_next_rescale_time(m_start + kRescalePeriod)
     , m_size(size)
     , m_alpha(alpha)
@@ -112,11 +164,47 @@ void ExponentiallyDecayingReservoir::update(long value)
 {
   rescale_if_needed();
 
-  std::lock_guard<std::mutex> lock(m_mutex);
+  TimedLock lock(m_mutex);
 
-  auto now = m_clock->now_as_time_t();
-  auto scale_factor = now - m_start;
+  auto scale_factor = SecondsNow(m_clock) - m_start;
+  update_locked(value, std::exp(m_alpha * scale_factor));
+}
+
+void ExponentiallyDecayingReservoir::update_weighted(long value, double weight)
+{
+  rescale_if_needed();
+
+  TimedLock lock(m_mutex);
+
+  // The extra weight rides along with the decay weight, raising both the
+  // sample's chance of being kept and its share of the snapshot.
+  auto scale_factor = SecondsNow(m_clock) - m_start;
+  update_locked(value, std::exp(m_alpha * scale_factor) * weight);
+}
+
+void ExponentiallyDecayingReservoir::update_batch(const long* values, std::size_t n)
+{
+  if (n == 0)
+  {
+    return;
+  }
+
+  rescale_if_needed();
+
+  TimedLock lock(m_mutex);
+
+  // Values in one batch all arrive at the same instant, so they share
+  // a weight as well as the lock.
+  auto scale_factor = SecondsNow(m_clock) - m_start;
   double item_weight = std::exp(m_alpha * scale_factor);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    update_locked(values[i], item_weight);
+  }
+}
+
+void ExponentiallyDecayingReservoir::update_locked(long value, double item_weight)
+{
   double priority = item_weight / dist(rd);
   
   auto new_size = m_count.fetch_add(1) + 1;
@@ -144,6 +232,7 @@ std::shared_ptr<Snapshot> ExponentiallyDecayingReservoir::get_snapshot()
 {
   rescale_if_needed();
 
+  SelfMetrics::Scope build(SelfMetrics::Duration::SnapshotBuild);
   std::lock_guard<std::mutex> lock(m_mutex);
 
   std::vector<WeightedSample> samples;
@@ -155,9 +244,14 @@ std::shared_ptr<Snapshot> ExponentiallyDecayingReservoir::get_snapshot()
   return std::make_shared<WeightedSnapshot>(std::move(samples));
 }
 
+std::size_t ExponentiallyDecayingReservoir::memory_usage() const noexcept
+{
+  return sizeof(ExponentiallyDecayingReservoir) + m_samples.get_allocator().bytes();
+}
+
 void ExponentiallyDecayingReservoir::rescale_if_needed()
 {
-  auto now = m_clock->now_as_time_t();
+  auto now = SecondsNow(m_clock);
   if (now >= m_next_rescale_time)
   {
     rescale(now, m_next_rescale_time);
@@ -166,11 +260,31 @@ void ExponentiallyDecayingReservoir::rescale_if_needed()
 
 void ExponentiallyDecayingReservoir::rescale(std::time_t now, std::time_t next)
 {
-  std::lock_guard<std::mutex> lock(m_mutex);
+  bool timed = SelfMetrics::is_enabled();
+  nanoseconds elapsed(0);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto start = timed ? steady_clock::now() : steady_clock::time_point();
+    rescale_locked(now);
+    if (timed)
+    {
+      elapsed = steady_clock::now() - start;
+    }
+  }
+
+  // As with TimedLock, record only once the lock is released; this may
+  // be the reservoir behind the very timer being recorded into.
+  if (timed)
+  {
+    SelfMetrics::record(SelfMetrics::Duration::ReservoirRescale, elapsed);
+  }
+}
 
+void ExponentiallyDecayingReservoir::rescale_locked(std::time_t now)
+{
   m_next_rescale_time = now + kRescalePeriod;
   const auto old_start_time = m_start;
-  m_start = m_clock->now_as_time_t();
+  m_start = SecondsNow(m_clock);
 
   const double scaling_factor = exp(-m_alpha * (m_start - old_start_time));
   if (HasEquivalentOrder(scaling_factor, 0.0))
@@ -0,0 +1,194 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "FrozenIndex.h"
+#include "MemoryUsage.h"
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+namespace cppmetrics {
+
+namespace {
+
+// Average number of keys per bucket.  Larger buckets mean a smaller
+// displacement table, but make displacements harder to find.
+constexpr const std::size_t kKeysPerBucket = 4;
+
+// How many displacements to try for one bucket before giving up and
+// rebuilding with a bigger table.
+constexpr const std::uint32_t kMaxDisplacement = 1u << 16;
+
+constexpr const std::size_t kMaxAttempts = 8;
+
+// From SplitMix64; a cheap, well-distributed 64-bit finalizer.
+inline std::uint64_t mix(std::uint64_t x) noexcept
+{
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+inline std::uint64_t hash_of(const std::string& name) noexcept
+{
+  return mix(std::hash<std::string>{}(name));
+}
+
+}
+
+FrozenIndex::FrozenIndex(std::vector<Entry>&& entries)
+    : m_size(entries.size())
+    , m_displacements()
+    , m_slots()
+{
+  std::vector<std::uint64_t> hashes;
+  hashes.reserve(entries.size());
+  for (auto&& entry : entries)
+  {
+    hashes.push_back(hash_of(entry.name));
+  }
+
+  // Start with a load factor of about 80%; each failed attempt
+  // grows the table, which makes the next one easier.
+  std::size_t num_slots = std::max<std::size_t>(1, entries.size() + entries.size() / 4);
+  for (std::size_t attempt = 0; attempt < kMaxAttempts; ++attempt)
+  {
+    m_displacements.assign(std::max<std::size_t>(1, entries.size() / kKeysPerBucket), 0);
+    m_slots.clear();
+    m_slots.resize(num_slots);
+
+    if (try_build(entries, hashes))
+    {
+      for (std::size_t i = 0; i < entries.size(); ++i)
+      {
+        Slot& slot = m_slots[slot_of(hashes[i], m_displacements[bucket_of(hashes[i])])];
+        slot.hash = hashes[i];
+        slot.entry = std::move(entries[i]);
+      }
+      return;
+    }
+
+    num_slots += num_slots / 2;
+  }
+
+  // Only reachable with a pathological std::hash.
+  throw std::runtime_error{"Unable to build a perfect hash of metric names"};
+}
+
+const FrozenIndex::Entry* FrozenIndex::find(const std::string& name) const noexcept
+{
+  if (m_size == 0)
+  {
+    return nullptr;
+  }
+
+  auto hash = hash_of(name);
+  const Slot& slot = m_slots[slot_of(hash, m_displacements[bucket_of(hash)])];
+  if (slot.hash != hash || slot.entry.metric == nullptr || slot.entry.name != name)
+  {
+    return nullptr;
+  }
+  return &slot.entry;
+}
+
+std::size_t FrozenIndex::memory_usage() const noexcept
+{
+  std::size_t bytes = sizeof(FrozenIndex)
+      + m_displacements.capacity() * sizeof(std::uint32_t)
+      + m_slots.capacity() * sizeof(Slot);
+  for (auto&& slot : m_slots)
+  {
+    bytes += MemoryUsage::Heap(slot.entry.name);
+  }
+  return bytes;
+}
+
+std::size_t FrozenIndex::bucket_of(std::uint64_t hash) const noexcept
+{
+  return static_cast<std::size_t>(hash % m_displacements.size());
+}
+
+std::size_t FrozenIndex::slot_of(std::uint64_t hash, std::uint32_t displacement) const noexcept
+{
+  return static_cast<std::size_t>(mix(hash ^ (displacement * 0x9e3779b97f4a7c15ULL)) % m_slots.size());
+}
+
+bool FrozenIndex::try_build(const std::vector<Entry>& entries, const std::vector<std::uint64_t>& hashes)
+{
+  std::vector<std::vector<std::size_t>> buckets(m_displacements.size());
+  for (std::size_t i = 0; i < entries.size(); ++i)
+  {
+    buckets[bucket_of(hashes[i])].push_back(i);
+  }
+
+  // Place the most crowded buckets first, while the table is emptiest.
+  std::vector<std::size_t> order(buckets.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](std::size_t lhs, std::size_t rhs) {
+    return buckets[lhs].size() > buckets[rhs].size();
+  });
+
+  std::vector<bool> taken(m_slots.size(), false);
+  std::vector<std::size_t> candidate;
+
+  for (std::size_t b : order)
+  {
+    const auto& keys = buckets[b];
+    if (keys.empty())
+    {
+      break;
+    }
+
+    bool placed = false;
+    for (std::uint32_t d = 0; d < kMaxDisplacement && !placed; ++d)
+    {
+      candidate.clear();
+      placed = true;
+      for (std::size_t key : keys)
+      {
+        auto slot = slot_of(hashes[key], d);
+        if (taken[slot] || std::find(candidate.begin(), candidate.end(), slot) != candidate.end())
+        {
+          placed = false;
+          break;
+        }
+        candidate.push_back(slot);
+      }
+
+      if (placed)
+      {
+        m_displacements[b] = d;
+        for (auto slot : candidate)
+        {
+          taken[slot] = true;
+        }
+      }
+    }
+
+    if (!placed)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}
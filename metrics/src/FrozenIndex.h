@@ -0,0 +1,83 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+// An immutable, perfectly-hashed map from metric names to metrics,
+// used by Registry once it has been frozen.
+
+#ifndef CPPMETRICS_METRICS_FROZENINDEX_H
+#define CPPMETRICS_METRICS_FROZENINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <metrics/Registry.h>
+
+namespace cppmetrics {
+
+class FrozenIndex
+{
+public:
+  struct Entry
+  {
+    std::string name;
+    MetricType type;
+    std::shared_ptr<void> metric;
+  };
+
+  /**
+   * Builds an index over |entries|, whose names must be unique.
+   *
+   * Uses "hash, displace, and compress" (Belazzougui et al.), minus the
+   * compression: keys are hashed into small buckets, and each bucket gets
+   * a displacement that sends all of its keys to distinct, unused slots.
+   * Lookups are then one hash, one displacement load, and one slot probe.
+   */
+  explicit FrozenIndex(std::vector<Entry>&& entries);
+
+  /**
+   * @return the entry for |name|, or nullptr if there isn't one.
+   */
+  const Entry* find(const std::string& name) const noexcept;
+
+  std::size_t size() const noexcept
+  {
+    return m_size;
+  }
+
+  std::size_t memory_usage() const noexcept;
+
+private:
+  struct Slot
+  {
+    std::uint64_t hash;
+    Entry entry;
+  };
+
+  std::size_t bucket_of(std::uint64_t hash) const noexcept;
+  std::size_t slot_of(std::uint64_t hash, std::uint32_t displacement) const noexcept;
+
+  bool try_build(const std::vector<Entry>& entries, const std::vector<std::uint64_t>& hashes);
+
+private:
+  std::size_t m_size;
+  std::vector<std::uint32_t> m_displacements;
+  std::vector<Slot> m_slots;
+};
+
+}
+
+#endif
@@ -17,12 +17,15 @@
 namespace cppmetrics {
 
 Gauge::Gauge()
+    : m_value(0)
+    , m_stamp()
 {
 
 }
 
 void Gauge::set(long value)
 {
+  m_stamp.touch();
   m_value.store(value);
 }
 
@@ -31,4 +34,14 @@ long Gauge::get()
   return m_value.load();
 }
 
+Epoch::value_t Gauge::last_update_epoch() const noexcept
+{
+  return m_stamp.get();
+}
+
+std::size_t Gauge::memory_usage() const noexcept
+{
+  return sizeof(Gauge);
+}
+
 }
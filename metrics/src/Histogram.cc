@@ -23,14 +23,23 @@ namespace cppmetrics {
 Histogram::Histogram(std::unique_ptr<Reservoir>&& reservoir)
     : m_counter(0)
     , m_reservoir(std::move(reservoir))
+    , m_stamp()
 {}
 
 void Histogram::update(long n)
 {
-  m_counter += n;
+  m_stamp.touch();
+  ++m_counter;
   m_reservoir->update(n);
 }
 
+void Histogram::update_batch(const long* values, std::size_t n)
+{
+  m_stamp.touch();
+  m_counter += static_cast<long>(n);
+  m_reservoir->update_batch(values, n);
+}
+
 long Histogram::get_count() const
 {
   return m_counter.load();
@@ -41,4 +50,14 @@ std::shared_ptr<Snapshot> Histogram::get_snapshot()
   return m_reservoir->get_snapshot();
 }
 
+Epoch::value_t Histogram::last_update_epoch() const noexcept
+{
+  return m_stamp.get();
+}
+
+std::size_t Histogram::memory_usage() const noexcept
+{
+  return sizeof(Histogram) + m_reservoir->memory_usage();
+}
+
 }
@@ -0,0 +1,183 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/LatencyTimer.h>
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include <metrics/Clock.h>
+#include <metrics/ExponentiallyDecayingReservoir.h>
+#include <metrics/Snapshot.h>
+
+#include "MemoryUsage.h"
+
+namespace cppmetrics {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr std::chrono::nanoseconds kTickInterval = 5s;
+
+}
+
+LatencyTimer::LatencyTimer()
+    : LatencyTimer(std::make_unique<ExponentiallyDecayingReservoir>())
+{}
+
+LatencyTimer::LatencyTimer(std::unique_ptr<Reservoir>&& reservoir)
+    : LatencyTimer(std::move(reservoir), nullptr)
+{}
+
+LatencyTimer::LatencyTimer(std::unique_ptr<Reservoir>&& reservoir, Clock* clock)
+    : m_clock(clock != nullptr ? clock : GetDefaultClock())
+    , m_reservoir(std::move(reservoir))
+    , m_count()
+    , m_start_time(m_clock->tick())
+    , m_rates_mutex()
+    , m_last_tick(m_start_time)
+    , m_ticked_count(0)
+    , m_m1(EWMA::alpha_for(1min, kTickInterval), kTickInterval)
+    , m_m5(EWMA::alpha_for(5min, kTickInterval), kTickInterval)
+    , m_m15(EWMA::alpha_for(15min, kTickInterval), kTickInterval)
+{}
+
+void LatencyTimer::update(const std::chrono::nanoseconds& nanos)
+{
+  if (nanos.count() >= 0)
+  {
+    record(nanos);
+    count();
+  }
+}
+
+void LatencyTimer::update_batch(const long* nanos, std::size_t n)
+{
+  if (std::all_of(nanos, nanos + n, [](long value) { return value >= 0; }))
+  {
+    m_reservoir->update_batch(nanos, n);
+    m_count.incr(static_cast<LongAdder::value_t>(n));
+    return;
+  }
+
+  std::vector<long> valid;
+  valid.reserve(n);
+  std::copy_if(nanos, nanos + n, std::back_inserter(valid), [](long value) { return value >= 0; });
+  m_reservoir->update_batch(valid.data(), valid.size());
+  m_count.incr(static_cast<LongAdder::value_t>(valid.size()));
+}
+
+void LatencyTimer::count() noexcept
+{
+  m_count.incr();
+}
+
+void LatencyTimer::record(const std::chrono::nanoseconds& nanos)
+{
+  m_reservoir->update(nanos.count());
+}
+
+void LatencyTimer::record(const std::chrono::nanoseconds& nanos, std::uint32_t weight)
+{
+  m_reservoir->update_weighted(nanos.count(), weight);
+}
+
+void LatencyTimer::update(const std::chrono::milliseconds& millis)
+{
+  update(std::chrono::duration_cast<std::chrono::nanoseconds>(millis));
+}
+
+long LatencyTimer::get_count() const noexcept
+{
+  return m_count.count();
+}
+
+double LatencyTimer::get_m1_rate()
+{
+  catch_up();
+  return m_m1.get_rate(std::chrono::seconds(1));
+}
+
+double LatencyTimer::get_m5_rate()
+{
+  catch_up();
+  return m_m5.get_rate(std::chrono::seconds(1));
+}
+
+double LatencyTimer::get_m15_rate()
+{
+  catch_up();
+  return m_m15.get_rate(std::chrono::seconds(1));
+}
+
+double LatencyTimer::get_mean_rate()
+{
+  auto count = get_count();
+  if (count == 0)
+  {
+    return 0.0;
+  }
+
+  auto elapsed = std::chrono::duration<double>(m_clock->tick() - m_start_time);
+  return count / elapsed.count();
+}
+
+std::shared_ptr<Snapshot> LatencyTimer::get_snapshot()
+{
+  return m_reservoir->get_snapshot();
+}
+
+std::size_t LatencyTimer::memory_usage() const noexcept
+{
+  return sizeof(LatencyTimer)
+      + m_reservoir->memory_usage()
+      + MemoryUsage::Owned(m_count);
+}
+
+void LatencyTimer::catch_up()
+{
+  std::lock_guard<std::mutex> lock(m_rates_mutex);
+
+  auto ticks = (m_clock->tick() - m_last_tick) / kTickInterval;
+  if (ticks <= 0)
+  {
+    return;
+  }
+
+  m_last_tick += ticks * kTickInterval;
+
+  auto count = m_count.count();
+  auto delta = count - m_ticked_count;
+  m_ticked_count = count;
+
+  for (auto* ewma : { &m_m1, &m_m5, &m_m15 })
+  {
+    ewma->tick_spread(delta, static_cast<std::uint64_t>(ticks));
+  }
+}
+
+LatencyTimer::Scope::Scope(LatencyTimer& timer)
+    : m_timer(timer)
+    , m_start(timer.m_clock->tick())
+{}
+
+LatencyTimer::Scope::~Scope()
+{
+  m_timer.update(m_timer.m_clock->tick() - m_start);
+}
+
+}
@@ -23,6 +23,8 @@
 #include <type_traits>
 #include <vector>
 
+#include <metrics/SelfMetrics.h>
+
 #include "AlignedAllocations.h"
 
 
@@ -159,6 +161,19 @@ LongAdder::value_t LongAdder::count() const noexcept
   return base;
 }
 
+std::size_t LongAdder::memory_usage() const noexcept
+{
+  std::size_t bytes = sizeof(LongAdder) + m_cells.capacity() * sizeof(Cell*);
+  for (auto&& cell : m_cells)
+  {
+    if (cell != nullptr)
+    {
+      bytes += sizeof(Cell);
+    }
+  }
+  return bytes;
+}
+
 void LongAdder::modify(value_t n)
 {
   bool collide = false;
@@ -209,10 +224,21 @@ void LongAdder::modify(value_t n)
         // woot
         break;
       }
-      else if (!collide)
+
+      if (SelfMetrics::is_enabled())
+      {
+        SelfMetrics::count(SelfMetrics::Count::CasFailures);
+      }
+
+      if (!collide)
       {
         collide = true;;
         h = Thread::id(true);
+
+        if (SelfMetrics::is_enabled())
+        {
+          SelfMetrics::count(SelfMetrics::Count::Rehashes);
+        }
       }
       else
       {
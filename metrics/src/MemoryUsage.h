@@ -0,0 +1,56 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+// Helpers shared by the memory_usage() implementations.
+
+#ifndef CPPMETRICS_METRICS_MEMORYUSAGE_H
+#define CPPMETRICS_METRICS_MEMORYUSAGE_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace cppmetrics { namespace MemoryUsage {
+
+// Our estimate of a std::make_shared control block, less the object
+// itself: a vtable pointer and the two reference counts.
+constexpr std::size_t kSharedControlBlock = sizeof(void*) + 2 * sizeof(int);
+
+/**
+ * The bytes a string holds on the heap; zero when its characters fit
+ * in the small-string buffer inside the object.
+ */
+inline std::size_t Heap(const std::string& str) noexcept
+{
+  const char* data = str.data();
+  const char* self = reinterpret_cast<const char*>(&str);
+
+  std::less<const char*> less;
+  bool inline_buffer = !less(data, self) && less(data, self + sizeof(str));
+  return inline_buffer ? 0 : str.capacity() + 1;
+}
+
+/**
+ * The bytes |member| owns beyond the object itself, given its total
+ * memory_usage().
+ */
+template <typename T>
+std::size_t Owned(const T& member) noexcept
+{
+  return member.memory_usage() - sizeof(T);
+}
+
+}}
+
+#endif
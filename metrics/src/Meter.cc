@@ -14,8 +14,12 @@
 
 #include <metrics/Meter.h>
 
+#include <new>
+#include <stdexcept>
+
 #include <metrics/Clock.h>
-#include <metrics/EWMA.h>
+
+#include "MemoryUsage.h"
 
 namespace cppmetrics {
 
@@ -24,74 +28,252 @@ namespace {
 using namespace std::chrono;
 using namespace std::chrono_literals;
 
-const long long kTickInterval = duration_cast<nanoseconds>(5s).count();
+}
+
+const MeterBase::duration MeterBase::kDefaultTickInterval = 5s;
+
+const std::vector<MeterBase::duration>& MeterBase::default_windows()
+{
+  static const std::vector<duration> windows{ 1min, 5min, 15min };
+  return windows;
+}
+
+MeterBase::Window::Window(const duration& length, const duration& tick_interval)
+    : length(length)
+    , ewma(EWMA::alpha_for(length, tick_interval), tick_interval)
+{}
+
+void MeterBase::check_windows(const std::vector<duration>& lengths, const duration& tick_interval)
+{
+  if (tick_interval <= duration::zero())
+  {
+    throw std::invalid_argument{"Meter needs a positive tick interval"};
+  }
+
+  if (lengths.empty())
+  {
+    throw std::invalid_argument{"Meter needs at least one window"};
+  }
+
+  for (auto&& length : lengths)
+  {
+    if (length <= duration::zero())
+    {
+      throw std::invalid_argument{"Meter windows must be positive"};
+    }
+  }
+}
+
+template <std::size_t InlineWindows>
+MeterBase::Windows<InlineWindows>::Windows(const std::vector<duration>& lengths, const duration& tick_interval)
+    : m_begin(reinterpret_cast<Window*>(m_inline))
+    , m_size(0)
+{
+  check_windows(lengths, tick_interval);
+
+  if (lengths.size() > InlineWindows)
+  {
+    m_begin = static_cast<Window*>(::operator new(lengths.size() * sizeof(Window)));
+  }
+
+  for (auto&& length : lengths)
+  {
+    new (m_begin + m_size) Window(length, tick_interval);
+    ++m_size;
+  }
+}
+
+template <std::size_t InlineWindows>
+MeterBase::Windows<InlineWindows>::~Windows()
+{
+  for (auto&& window : *this)
+  {
+    window.~Window();
+  }
+
+  if (!is_inline())
+  {
+    ::operator delete(m_begin);
+  }
+}
 
+template <std::size_t InlineWindows>
+std::size_t MeterBase::Windows<InlineWindows>::heap_bytes() const noexcept
+{
+  return is_inline() ? 0 : m_size * sizeof(Window);
 }
 
-Meter::Meter(Clock* clock)
-    : m_clock(clock != nullptr ? clock : GetDefaultClock())
-    , m_count(0)
-    , m_start_time(m_clock->tick())
+template <std::size_t InlineWindows>
+bool MeterBase::Windows<InlineWindows>::is_inline() const noexcept
+{
+  return m_begin == reinterpret_cast<const Window*>(m_inline);
+}
+
+template <typename ClockPolicy, std::size_t InlineWindows>
+BasicMeter<ClockPolicy, InlineWindows>::BasicMeter(ClockPolicy clock)
+    : BasicMeter(default_windows(), kDefaultTickInterval, clock)
+{}
+
+template <typename ClockPolicy, std::size_t InlineWindows>
+BasicMeter<ClockPolicy, InlineWindows>::BasicMeter(const std::vector<duration>& windows, const duration& tick_interval, ClockPolicy clock)
+    : m_clock(clock)
+    , m_tick_interval(tick_interval)
+    , m_count()
+    , m_start_time(m_clock.tick())
     , m_last_tick(m_start_time.count())
-    , m_m1( EWMA::one_minute() )
-    , m_m5( EWMA::five_minutes() )
-    , m_m15( EWMA::fifteen_minutes() )
+    , m_ticked_count(0)
+    , m_externally_ticked(false)
+    , m_windows(windows, tick_interval)
+    , m_stamp()
 {}
 
-void Meter::mark(long n)
+template <typename ClockPolicy, std::size_t InlineWindows>
+void BasicMeter<ClockPolicy, InlineWindows>::mark(long n)
+{
+  m_stamp.touch();
+  if (!is_externally_ticked())
+  {
+    tick_if_necessary();
+  }
+  m_count.incr(n);
+}
+
+template <typename ClockPolicy, std::size_t InlineWindows>
+void BasicMeter<ClockPolicy, InlineWindows>::tick()
 {
   tick_if_necessary();
-  m_count += n;
-  m_m1->update(n);
-  m_m5->update(n);
-  m_m15->update(n);
 }
 
-void Meter::tick_if_necessary()
+template <typename ClockPolicy, std::size_t InlineWindows>
+void BasicMeter<ClockPolicy, InlineWindows>::set_externally_ticked(bool externally_ticked) noexcept
+{
+  m_externally_ticked.store(externally_ticked, std::memory_order_relaxed);
+}
+
+template <typename ClockPolicy, std::size_t InlineWindows>
+bool BasicMeter<ClockPolicy, InlineWindows>::is_externally_ticked() const noexcept
+{
+  return m_externally_ticked.load(std::memory_order_relaxed);
+}
+
+template <typename ClockPolicy, std::size_t InlineWindows>
+void BasicMeter<ClockPolicy, InlineWindows>::tick_if_necessary()
 {
   auto old_tick = m_last_tick.load();
-  auto new_tick = m_clock->tick().count();
+  auto new_tick = m_clock.tick().count();
   auto age = new_tick - old_tick;
-  if (age > kTickInterval)
+  auto interval = m_tick_interval.count();
+  if (age > interval)
   {
-    auto new_interval_start_tick = new_tick - age % kTickInterval;
+    auto new_interval_start_tick = new_tick - age % interval;
     if (std::atomic_compare_exchange_strong(&m_last_tick, &old_tick, new_interval_start_tick))
     {
-      auto required_ticks = age / kTickInterval;
-      for (int i = 0; i < required_ticks; ++i)
+      // Fan everything marked since the last tick out to the averages.
+      // Marks that race with this read are simply counted in the next
+      // interval instead.
+      auto count = m_count.count();
+      auto delta = count - m_ticked_count.exchange(count);
+
+      // However long we've been idle, catching up takes constant time.
+      // Ticked lazily, anything marked since the last tick was marked in
+      // the interval just after it, or a tick would have happened sooner.
+      // Ticked externally, possibly less often than our own interval, the
+      // marks may have landed anywhere in between.
+      auto required_ticks = static_cast<std::uint64_t>(age / interval);
+      auto spread = is_externally_ticked();
+      for (auto&& window : m_windows)
       {
-        m_m1->tick();
-        m_m5->tick();
-        m_m15->tick();
+        if (spread)
+        {
+          window.ewma.tick_spread(delta, required_ticks);
+        }
+        else
+        {
+          window.ewma.update(delta);
+          window.ewma.tick_n(required_ticks);
+        }
       }
     }
   }
 }
 
-long Meter::get_count() const noexcept
+template <typename ClockPolicy, std::size_t InlineWindows>
+long BasicMeter<ClockPolicy, InlineWindows>::get_count() const noexcept
 {
-  return m_count.load();
+  return m_count.count();
 }
 
-double Meter::get_m1_rate()
+template <typename ClockPolicy, std::size_t InlineWindows>
+double BasicMeter<ClockPolicy, InlineWindows>::get_m1_rate()
 {
-  tick_if_necessary();
-  return m_m1->get_rate(std::chrono::seconds(1));
+  return get_rate(1min);
 }
 
-double Meter::get_m5_rate()
+template <typename ClockPolicy, std::size_t InlineWindows>
+double BasicMeter<ClockPolicy, InlineWindows>::get_m5_rate()
 {
-  tick_if_necessary();
-  return m_m5->get_rate(std::chrono::seconds(1));
+  return get_rate(5min);
 }
 
-double Meter::get_m15_rate()
+template <typename ClockPolicy, std::size_t InlineWindows>
+double BasicMeter<ClockPolicy, InlineWindows>::get_m15_rate()
 {
-  tick_if_necessary();
-  return m_m15->get_rate(std::chrono::seconds(1));
+  return get_rate(15min);
 }
 
-double Meter::get_mean_rate()
+template <typename ClockPolicy, std::size_t InlineWindows>
+double BasicMeter<ClockPolicy, InlineWindows>::get_rate(const duration& window)
+{
+  if (!is_externally_ticked())
+  {
+    tick_if_necessary();
+  }
+
+  for (auto&& w : m_windows)
+  {
+    if (w.length == window)
+    {
+      return w.ewma.get_rate(std::chrono::seconds(1));
+    }
+  }
+
+  throw std::invalid_argument{"Meter does not track the requested window"};
+}
+
+template <typename ClockPolicy, std::size_t InlineWindows>
+std::vector<MeterBase::duration> BasicMeter<ClockPolicy, InlineWindows>::get_windows() const
+{
+  std::vector<duration> result;
+  result.reserve(m_windows.size());
+  for (auto&& window : m_windows)
+  {
+    result.push_back(window.length);
+  }
+  return result;
+}
+
+template <typename ClockPolicy, std::size_t InlineWindows>
+MeterBase::duration BasicMeter<ClockPolicy, InlineWindows>::get_tick_interval() const noexcept
+{
+  return m_tick_interval;
+}
+
+template <typename ClockPolicy, std::size_t InlineWindows>
+Epoch::value_t BasicMeter<ClockPolicy, InlineWindows>::last_update_epoch() const noexcept
+{
+  return m_stamp.get();
+}
+
+template <typename ClockPolicy, std::size_t InlineWindows>
+std::size_t BasicMeter<ClockPolicy, InlineWindows>::memory_usage() const noexcept
+{
+  return sizeof(BasicMeter)
+      + MemoryUsage::Owned(m_count)
+      + m_windows.heap_bytes();
+}
+
+template <typename ClockPolicy, std::size_t InlineWindows>
+double BasicMeter<ClockPolicy, InlineWindows>::get_mean_rate()
 {
   auto count = get_count();
   if (count == 0)
@@ -100,8 +282,19 @@ double Meter::get_mean_rate()
   }
 
   constexpr auto kNanosPerSecond = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::seconds(1)).count();
-  auto elapsed = m_clock->tick() - m_start_time;
+  auto elapsed = m_clock.tick() - m_start_time;
   return static_cast<double>(count) / elapsed.count() * kNanosPerSecond;
 }
 
+template class MeterBase::Windows<1>;
+template class MeterBase::Windows<2>;
+template class MeterBase::Windows<3>;
+
+template class BasicMeter<ClockRef, 1>;
+template class BasicMeter<ClockRef, 2>;
+template class BasicMeter<ClockRef, 3>;
+template class BasicMeter<SteadyClockPolicy, 1>;
+template class BasicMeter<SteadyClockPolicy, 2>;
+template class BasicMeter<SteadyClockPolicy, 3>;
+
 }
@@ -14,13 +14,35 @@
 
 #include <metrics/OStreamReporter.h>
 
+#include <chrono>
 #include <iostream>
+#include <string>
 #include <utility>
 
 #include <metrics/metrics.h>
 
 namespace cppmetrics {
 
+namespace {
+
+// "m1", "m5", "m15" for the classic windows; finer ones by their unit.
+std::string window_label(const std::chrono::nanoseconds& window)
+{
+  using namespace std::chrono;
+
+  if (window.count() % duration_cast<nanoseconds>(minutes(1)).count() == 0)
+  {
+    return "m" + std::to_string(duration_cast<minutes>(window).count());
+  }
+  if (window.count() % duration_cast<nanoseconds>(seconds(1)).count() == 0)
+  {
+    return "s" + std::to_string(duration_cast<seconds>(window).count());
+  }
+  return "ms" + std::to_string(duration_cast<milliseconds>(window).count());
+}
+
+}
+
 OStreamReporter::OStreamReporter(std::ostream& output, const std::shared_ptr<Registry>& registry)
     : m_output(output)
     , m_registry(registry)
@@ -40,16 +62,22 @@ void OStreamReporter::report()
 
   for (auto&& gauge : m_registry->get_gauges())
   {
-    //m_output << counter.first << "\t" << counter.second->
+    m_output << gauge.first << "\t" << gauge.second->get() << "\n";
+  }
+
+  for (auto&& gauge : m_registry->get_double_gauges())
+  {
+    m_output << gauge.first << "\t" << gauge.second->get() << "\n";
   }
 
   for (auto&& meter : m_registry->get_meters())
   {
     m_output << meter.first << ".count\t" << meter.second->get_count() << "\n";
     m_output << meter.first << ".mean\t" << meter.second->get_mean_rate() << "\n";
-    m_output << meter.first << ".m1\t" << meter.second->get_m1_rate() << "\n";
-    m_output << meter.first << ".m5\t" << meter.second->get_m5_rate() << "\n";
-    m_output << meter.first << ".m15\t" << meter.second->get_m15_rate() << "\n";
+    for (auto&& window : meter.second->get_windows())
+    {
+      m_output << meter.first << "." << window_label(window) << "\t" << meter.second->get_rate(window) << "\n";
+    }
   }
 
   for (auto&& histogram : m_registry->get_histograms())
@@ -0,0 +1,53 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/RatioGauge.h>
+
+#include <limits>
+#include <utility>
+
+#include <metrics/Counter.h>
+
+namespace cppmetrics {
+
+RatioGauge::RatioGauge(std::shared_ptr<Counter> numerator, std::shared_ptr<Counter> denominator)
+    : m_numerator(std::move(numerator))
+    , m_denominator(std::move(denominator))
+{}
+
+double RatioGauge::get()
+{
+  auto denominator = m_denominator->get_count();
+  if (denominator == 0)
+  {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  return static_cast<double>(m_numerator->get_count()) / denominator;
+}
+
+Epoch::value_t RatioGauge::last_update_epoch() const noexcept
+{
+  // As current as the counters behind it.
+  return Epoch::is_before(m_numerator->last_update_epoch(), m_denominator->last_update_epoch())
+      ? m_denominator->last_update_epoch()
+      : m_numerator->last_update_epoch();
+}
+
+std::size_t RatioGauge::memory_usage() const noexcept
+{
+  // The counters are shared, and counted wherever they are registered.
+  return sizeof(RatioGauge);
+}
+
+}
@@ -12,16 +12,27 @@
 //  See the License for the specific language governing permissions and
 //  limitations under the License.
 
-
 #include <metrics/Registry.h>
 
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+#include <metrics/Clock.h>
 #include <metrics/Counter.h>
 #include <metrics/ExponentiallyDecayingReservoir.h>
+#include <metrics/CachedGauge.h>
+#include <metrics/CallbackGauge.h>
+#include <metrics/DoubleGauge.h>
 #include <metrics/Gauge.h>
 #include <metrics/Meter.h>
 #include <metrics/Histogram.h>
+#include <metrics/StaticMetrics.h>
 #include <metrics/Timer.h>
 
+#include "FrozenIndex.h"
+#include "MemoryUsage.h"
+
 namespace cppmetrics {
 
 template <typename M>
@@ -30,61 +41,656 @@ using MetricPtr = std::shared_ptr<M>;
 template <typename M>
 using MMap = std::map<std::string, MetricPtr<M>>;
 
+namespace {
+
+constexpr
+inline
+std::size_t
+next_power_of_two(std::size_t n) noexcept
+{
+  std::size_t result = 1;
+  while (result < n)
+  {
+    result <<= 1;
+  }
+  return result;
+}
+
+MetricPtr<Gauge> make_gauge()
+{
+  return std::make_shared<Gauge>();
+}
+
+MetricPtr<DoubleGauge> make_double_gauge()
+{
+  return std::make_shared<DoubleGauge>();
+}
+
+MetricPtr<Counter> make_counter()
+{
+  return std::make_shared<Counter>();
+}
+
+MetricPtr<Meter> make_meter()
+{
+  return std::make_shared<Meter>();
+}
+
+MetricPtr<Histogram> make_histogram()
+{
+  return std::make_shared<Histogram>(std::make_unique<ExponentiallyDecayingReservoir>());
+}
+
+MetricPtr<Timer> make_timer()
+{
+  return std::make_shared<Timer>();
+}
+
+// The names and metrics in one of a shard's maps; the nodes themselves
+// are counted by the shard's allocator.
+template <typename Map>
+std::size_t MetricsUsage(const Map& metrics)
+{
+  std::size_t bytes = 0;
+  for (auto&& pair : metrics)
+  {
+    bytes += MemoryUsage::Heap(pair.first)
+        + MemoryUsage::kSharedControlBlock
+        + pair.second->memory_usage();
+  }
+  return bytes;
+}
+
+} // namespace
+
+const std::size_t Registry::kDefaultShardCount = 16;
+
+Registry::Registry(std::size_t shard_count)
+    : m_shards()
+    , m_expiry_mutex()
+    , m_expiry_clock(GetDefaultClock())
+    , m_idle_ttl(0)
+    , m_sweeps()
+    , m_freeze_mutex()
+    , m_frozen(nullptr)
+    , m_freeze_policy(FreezePolicy::AllowOverflow)
+    , m_indices()
+    , m_externally_ticked(false)
+    , m_ticker_mutex()
+    , m_ticker_cv()
+    , m_ticker_running(false)
+    , m_ticker_interval(0)
+    , m_ticker_thread()
+{
+  // A power-of-two shard count lets us pick a shard with a mask
+  // rather than a division.
+  m_shards.resize(next_power_of_two(shard_count));
+  for (auto&& shard : m_shards)
+  {
+    shard = std::make_unique<Shard>();
+  }
+}
+
+Registry::~Registry()
+{
+  stop_ticker();
+}
+
+Registry::Shard::Shard()
+    : mutex()
+    , allocator()
+    , names(allocator)
+    , gauges(allocator)
+    , counters(allocator)
+    , meters(allocator)
+    , histograms(allocator)
+    , timers(allocator)
+    , double_gauges(allocator)
+{}
+
+std::size_t Registry::shard_count() const noexcept
+{
+  return m_shards.size();
+}
+
+std::size_t Registry::shard_index(const std::string& name) const noexcept
+{
+  std::size_t hash = std::hash<std::string>{}(name);
+
+  // Fold the high bits in; some standard libraries hash short strings
+  // with poor entropy in the low bits.
+  hash ^= hash >> 16;
+  return hash & (m_shards.size() - 1);
+}
+
+Registry::Shard& Registry::shard_for(const std::string& name)
+{
+  return *m_shards[shard_index(name)];
+}
+
 MetricPtr<Gauge> Registry::gauge(const std::string& name)
 {
-  return get_or_add(name, m_gauges, []() { return std::make_shared<Gauge>(); });
+  // Computed gauges share the collection, but can't be set.
+  return std::dynamic_pointer_cast<Gauge>(get_or_add(name, MetricType::Gauge, &Shard::gauges, make_gauge));
+}
+
+MetricPtr<GaugeBase> Registry::gauge(const std::string& name, std::function<long()> fn)
+{
+  return get_or_add(name, MetricType::Gauge, &Shard::gauges, [&]() -> MetricPtr<GaugeBase> {
+    return std::make_shared<CallbackGauge>(std::move(fn));
+  });
+}
+
+MetricPtr<GaugeBase> Registry::gauge(const std::string& name, std::function<long()> fn, const std::chrono::nanoseconds& ttl)
+{
+  return get_or_add(name, MetricType::Gauge, &Shard::gauges, [&]() -> MetricPtr<GaugeBase> {
+    return std::make_shared<CachedGauge>(std::move(fn), ttl);
+  });
+}
+
+MetricPtr<DoubleGauge> Registry::double_gauge(const std::string& name)
+{
+  return std::dynamic_pointer_cast<DoubleGauge>(get_or_add(name, MetricType::DoubleGauge, &Shard::double_gauges, make_double_gauge));
 }
 
 MetricPtr<Counter> Registry::counter(const std::string& name)
 {
-  return get_or_add(name, m_counters, []() { return std::make_shared<Counter>(); });
+  return get_or_add(name, MetricType::Counter, &Shard::counters, make_counter);
 }
 
 MetricPtr<Meter> Registry::meter(const std::string& name)
 {
-  return get_or_add(name, m_meters, []() { return std::make_shared<Meter>(); });
+  return get_or_add(name, MetricType::Meter, &Shard::meters, make_meter);
 }
 
-MetricPtr<Histogram> Registry::histogram(const std::string& name)
+MetricPtr<Meter> Registry::meter(const std::string& name,
+                                 const std::vector<std::chrono::nanoseconds>& windows,
+                                 const std::chrono::nanoseconds& tick_interval)
 {
-  return get_or_add(name, m_histograms, []() {
-    return std::make_shared<Histogram>(std::make_unique<ExponentiallyDecayingReservoir>());
+  return get_or_add(name, MetricType::Meter, &Shard::meters, [&]() {
+    return std::make_shared<Meter>(windows, tick_interval);
   });
 }
 
+MetricPtr<Histogram> Registry::histogram(const std::string& name)
+{
+  return get_or_add(name, MetricType::Histogram, &Shard::histograms, make_histogram);
+}
+
 MetricPtr<Timer> Registry::timer(const std::string& name)
 {
-  return get_or_add(name, m_timers, []() { return std::make_shared<Timer>(); });
+  return get_or_add(name, MetricType::Timer, &Shard::timers, make_timer);
+}
+
+bool Registry::add(const std::string& name, const MetricPtr<GaugeBase>& gauge)
+{
+  return put(name, &Shard::gauges, gauge);
+}
+
+bool Registry::add(const std::string& name, const MetricPtr<DoubleGaugeBase>& gauge)
+{
+  return put(name, &Shard::double_gauges, gauge);
+}
+
+bool Registry::add(const std::string& name, const MetricPtr<Counter>& counter)
+{
+  return put(name, &Shard::counters, counter);
+}
+
+bool Registry::add(const std::string& name, const MetricPtr<Meter>& meter)
+{
+  return put(name, &Shard::meters, meter);
+}
+
+bool Registry::add(const std::string& name, const MetricPtr<Histogram>& histogram)
+{
+  return put(name, &Shard::histograms, histogram);
+}
+
+bool Registry::add(const std::string& name, const MetricPtr<Timer>& timer)
+{
+  return put(name, &Shard::timers, timer);
+}
+
+std::size_t Registry::register_static_metrics()
+{
+  std::size_t added = 0;
+  for (auto metric = StaticMetricBase::head(); metric != nullptr; metric = metric->next())
+  {
+    if (metric->register_with(*this))
+    {
+      ++added;
+    }
+  }
+  return added;
+}
+
+std::size_t Registry::register_all(MetricType type, const std::vector<std::string>& names)
+{
+  switch (type)
+  {
+  case MetricType::Gauge:     return add_all(names, &Shard::gauges, make_gauge);
+  case MetricType::Counter:   return add_all(names, &Shard::counters, make_counter);
+  case MetricType::Meter:     return add_all(names, &Shard::meters, make_meter);
+  case MetricType::Histogram: return add_all(names, &Shard::histograms, make_histogram);
+  case MetricType::Timer:     return add_all(names, &Shard::timers, make_timer);
+  case MetricType::DoubleGauge: return add_all(names, &Shard::double_gauges, make_double_gauge);
+  }
+  return 0;
+}
+
+void Registry::freeze(FreezePolicy policy)
+{
+  std::lock_guard<std::mutex> freeze_lock(m_freeze_mutex);
+
+  std::vector<FrozenIndex::Entry> entries;
+  for (auto&& shard : m_shards)
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(shard->mutex);
+    for (auto&& pair : shard->gauges)     entries.push_back({pair.first, MetricType::Gauge, pair.second});
+    for (auto&& pair : shard->counters)   entries.push_back({pair.first, MetricType::Counter, pair.second});
+    for (auto&& pair : shard->meters)     entries.push_back({pair.first, MetricType::Meter, pair.second});
+    for (auto&& pair : shard->histograms) entries.push_back({pair.first, MetricType::Histogram, pair.second});
+    for (auto&& pair : shard->timers)     entries.push_back({pair.first, MetricType::Timer, pair.second});
+    for (auto&& pair : shard->double_gauges) entries.push_back({pair.first, MetricType::DoubleGauge, pair.second});
+  }
+
+  m_indices.push_back(std::make_unique<FrozenIndex>(std::move(entries)));
+  m_freeze_policy.store(policy);
+  m_frozen.store(m_indices.back().get(), std::memory_order_release);
+}
+
+bool Registry::is_frozen() const noexcept
+{
+  return m_frozen.load(std::memory_order_acquire) != nullptr;
 }
 
-MMap<Gauge> Registry::get_gauges()
+bool Registry::find_frozen(const std::string& name, MetricType type, std::shared_ptr<void>& metric) const
 {
-  std::shared_lock<std::shared_timed_mutex> lock(m_mutex);
-  return m_gauges;
+  const FrozenIndex* index = m_frozen.load(std::memory_order_acquire);
+  if (index == nullptr)
+  {
+    return false;
+  }
+
+  const FrozenIndex::Entry* entry = index->find(name);
+  if (entry == nullptr)
+  {
+    return false;
+  }
+
+  // Like the unfrozen path, a name of the wrong type yields nullptr.
+  if (entry->type == type)
+  {
+    metric = entry->metric;
+  }
+  return true;
+}
+
+bool Registry::is_frozen_name(const std::string& name) const
+{
+  const FrozenIndex* index = m_frozen.load(std::memory_order_acquire);
+  return index != nullptr && index->find(name) != nullptr;
+}
+
+void Registry::ensure_not_rejecting() const
+{
+  if (is_frozen() && m_freeze_policy.load() == FreezePolicy::RejectNew)
+  {
+    throw std::logic_error{"Registry is frozen and does not accept new metrics"};
+  }
+}
+
+MMap<GaugeBase> Registry::get_gauges()
+{
+  return collect(&Shard::gauges);
 }
 
 MMap<Counter> Registry::get_counters()
 {
-  std::shared_lock<std::shared_timed_mutex> lock(m_mutex);
-  return m_counters;
+  return collect(&Shard::counters);
 }
 
 MMap<Meter> Registry::get_meters()
 {
-  std::shared_lock<std::shared_timed_mutex> lock(m_mutex);
-  return m_meters;
+  return collect(&Shard::meters);
 }
 
 MMap<Histogram> Registry::get_histograms()
 {
-  std::shared_lock<std::shared_timed_mutex> lock(m_mutex);
-  return m_histograms;
+  return collect(&Shard::histograms);
 }
 
 MMap<Timer> Registry::get_timers()
 {
-  std::shared_lock<std::shared_timed_mutex> lock(m_mutex);
-  return m_timers;
+  return collect(&Shard::timers);
+}
+
+MMap<DoubleGaugeBase> Registry::get_double_gauges()
+{
+  return collect(&Shard::double_gauges);
+}
+
+bool Registry::remove(const std::string& name)
+{
+  Shard& shard = shard_for(name);
+
+  std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+  if (shard.names.find(name) == shard.names.end() || is_frozen_name(name))
+  {
+    return false;
+  }
+
+  erase_locked(shard, name);
+  return true;
+}
+
+std::size_t Registry::remove_if(const std::function<bool(const std::string&)>& predicate)
+{
+  std::size_t removed = 0;
+  std::vector<std::string> doomed;
+
+  for (auto&& shard : m_shards)
+  {
+    std::unique_lock<std::shared_timed_mutex> lock(shard->mutex);
+
+    doomed.clear();
+    for (auto&& name : shard->names)
+    {
+      if (predicate(name) && !is_frozen_name(name))
+      {
+        doomed.push_back(name);
+      }
+    }
+
+    for (auto&& name : doomed)
+    {
+      erase_locked(*shard, name);
+    }
+
+    removed += doomed.size();
+  }
+
+  return removed;
+}
+
+void Registry::set_idle_ttl(const std::chrono::nanoseconds& ttl, Clock* clock)
+{
+  std::lock_guard<std::mutex> lock(m_expiry_mutex);
+  m_expiry_clock = clock != nullptr ? clock : GetDefaultClock();
+  m_idle_ttl = ttl;
+  m_sweeps.clear();
+}
+
+std::size_t Registry::evict_idle()
+{
+  std::lock_guard<std::mutex> lock(m_expiry_mutex);
+  if (m_idle_ttl.count() <= 0)
+  {
+    return 0;
+  }
+
+  // Start a new epoch.  Anything updated from here on will carry a stamp
+  // at least this new, so remembering when each epoch started tells us
+  // an upper bound on when a given stamp was last touched.
+  auto now = m_expiry_clock->tick();
+  m_sweeps.emplace_back(Epoch::advance(), now);
+
+  // Find the newest epoch that started at least one TTL ago; metrics
+  // stamped before it have been idle for at least that long.  Older
+  // records are no longer useful.
+  auto horizon = now - m_idle_ttl;
+  bool found = false;
+  Epoch::value_t cutoff = 0;
+  while (!m_sweeps.empty() && m_sweeps.front().second <= horizon)
+  {
+    cutoff = m_sweeps.front().first;
+    found = true;
+    if (m_sweeps.size() > 1 && m_sweeps[1].second <= horizon)
+    {
+      m_sweeps.pop_front();
+    }
+    else
+    {
+      break;
+    }
+  }
+
+  if (!found)
+  {
+    return 0;
+  }
+
+  std::size_t evicted = 0;
+  for (auto&& shard : m_shards)
+  {
+    std::unique_lock<std::shared_timed_mutex> shard_lock(shard->mutex);
+    evicted += evict_from(*shard, &Shard::gauges, cutoff);
+    evicted += evict_from(*shard, &Shard::counters, cutoff);
+    evicted += evict_from(*shard, &Shard::meters, cutoff);
+    evicted += evict_from(*shard, &Shard::histograms, cutoff);
+    evicted += evict_from(*shard, &Shard::timers, cutoff);
+    evicted += evict_from(*shard, &Shard::double_gauges, cutoff);
+  }
+  return evicted;
+}
+
+template <typename T>
+std::size_t Registry::evict_from(Shard& shard, Collection<T> collection, Epoch::value_t cutoff)
+{
+  std::size_t evicted = 0;
+  auto& metrics = shard.*collection;
+  for (auto it = metrics.begin(); it != metrics.end(); )
+  {
+    if (Epoch::is_before(it->second->last_update_epoch(), cutoff) && !is_frozen_name(it->first))
+    {
+      on_removed(it->second);
+      shard.names.erase(it->first);
+      it = metrics.erase(it);
+      ++evicted;
+    }
+    else
+    {
+      ++it;
+    }
+  }
+  return evicted;
+}
+
+void Registry::enable_self_metrics(const std::string& prefix)
+{
+  SelfMetrics::set_enabled(true);
+
+  for (auto&& counter : SelfMetrics::get_counters())
+  {
+    add(prefix + "." + counter.first, counter.second);
+  }
+  for (auto&& timer : SelfMetrics::get_timers())
+  {
+    add(prefix + "." + timer.first, timer.second);
+  }
+}
+
+std::size_t Registry::memory_usage()
+{
+  std::size_t bytes = sizeof(Registry) + m_shards.capacity() * sizeof(std::unique_ptr<Shard>);
+
+  for (auto&& shard : m_shards)
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(shard->mutex);
+    bytes += sizeof(Shard) + shard->allocator.bytes();
+    for (auto&& name : shard->names)
+    {
+      bytes += MemoryUsage::Heap(name);
+    }
+    bytes += MetricsUsage(shard->gauges);
+    bytes += MetricsUsage(shard->counters);
+    bytes += MetricsUsage(shard->meters);
+    bytes += MetricsUsage(shard->histograms);
+    bytes += MetricsUsage(shard->timers);
+    bytes += MetricsUsage(shard->double_gauges);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_expiry_mutex);
+    bytes += m_sweeps.size() * sizeof(m_sweeps.front());
+  }
+
+  std::lock_guard<std::mutex> lock(m_freeze_mutex);
+  bytes += m_indices.capacity() * sizeof(std::unique_ptr<FrozenIndex>);
+  for (auto&& index : m_indices)
+  {
+    bytes += index->memory_usage();
+  }
+  return bytes;
+}
+
+void Registry::erase_locked(Shard& shard, const std::string& name)
+{
+  auto meter = shard.meters.find(name);
+  if (meter != shard.meters.end())
+  {
+    on_removed(meter->second);
+  }
+
+  auto timer = shard.timers.find(name);
+  if (timer != shard.timers.end())
+  {
+    on_removed(timer->second);
+  }
+
+  shard.names.erase(name);
+  shard.gauges.erase(name);
+  shard.counters.erase(name);
+  shard.meters.erase(name);
+  shard.histograms.erase(name);
+  shard.timers.erase(name);
+  shard.double_gauges.erase(name);
+}
+
+void Registry::on_added(const MetricPtr<Meter>& meter)
+{
+  // Under the shard's lock, so this can't interleave with
+  // set_externally_ticked() visiting the shard.
+  meter->set_externally_ticked(m_externally_ticked.load());
+}
+
+void Registry::on_added(const MetricPtr<Timer>& timer)
+{
+  timer->m_meter.set_externally_ticked(m_externally_ticked.load());
+}
+
+void Registry::on_removed(const MetricPtr<Meter>& meter)
+{
+  // Nobody else is going to tick it now.
+  meter->set_externally_ticked(false);
+}
+
+void Registry::on_removed(const MetricPtr<Timer>& timer)
+{
+  timer->m_meter.set_externally_ticked(false);
+}
+
+void Registry::start_ticker(const std::chrono::nanoseconds& interval)
+{
+  std::unique_lock<std::mutex> lock(m_ticker_mutex);
+  if (m_ticker_running)
+  {
+    return;
+  }
+
+  m_ticker_running = true;
+  m_ticker_interval = interval;
+
+  // Bring everything up to date before handing it over, so that
+  // nothing is left waiting on a tick for a whole interval.
+  tick_all();
+  set_externally_ticked(true);
+
+  m_ticker_thread = std::thread([this]() {
+    loop_ticking();
+  });
+}
+
+void Registry::stop_ticker()
+{
+  std::unique_lock<std::mutex> lock(m_ticker_mutex);
+  if (!m_ticker_running)
+  {
+    return;
+  }
+
+  m_ticker_running = false;
+  m_ticker_cv.notify_all();
+  lock.unlock();
+
+  if (m_ticker_thread.joinable())
+  {
+    m_ticker_thread.join();
+  }
+
+  set_externally_ticked(false);
+}
+
+void Registry::set_externally_ticked(bool externally_ticked)
+{
+  m_externally_ticked.store(externally_ticked);
+
+  // Exclusively, so that a metric is either added before we visit its
+  // shard, and updated here, or after, and sees the new flag.
+  for (auto&& shard : m_shards)
+  {
+    std::unique_lock<std::shared_timed_mutex> lock(shard->mutex);
+    for (auto&& pair : shard->meters)
+    {
+      pair.second->set_externally_ticked(externally_ticked);
+    }
+
+    for (auto&& pair : shard->timers)
+    {
+      pair.second->m_meter.set_externally_ticked(externally_ticked);
+    }
+  }
+}
+
+void Registry::tick_all()
+{
+  for (auto&& shard : m_shards)
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(shard->mutex);
+    for (auto&& pair : shard->meters)
+    {
+      pair.second->tick();
+    }
+
+    for (auto&& pair : shard->timers)
+    {
+      pair.second->m_meter.tick();
+    }
+  }
+}
+
+void Registry::loop_ticking()
+{
+  std::unique_lock<std::mutex> lock(m_ticker_mutex);
+  auto next_tick_time = std::chrono::steady_clock::now() + m_ticker_interval;
+  while (true)
+  {
+    m_ticker_cv.wait_until(lock, next_tick_time, [&]() {
+      return !m_ticker_running;
+    });
+
+    if (!m_ticker_running)
+    {
+      return;
+    }
+
+    lock.unlock();
+    tick_all();
+    lock.lock();
+
+    next_tick_time += m_ticker_interval;
+  }
 }
 
 }
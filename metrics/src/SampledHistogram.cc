@@ -0,0 +1,80 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/SampledHistogram.h>
+
+#include <utility>
+
+#include <metrics/Snapshot.h>
+
+#include "MemoryUsage.h"
+
+namespace cppmetrics {
+
+SampledHistogram::SampledHistogram(std::unique_ptr<Reservoir>&& reservoir, std::uint32_t interval)
+    : m_sampler(interval)
+    , m_count()
+    , m_recorded()
+    , m_reservoir(std::move(reservoir))
+{}
+
+SampledHistogram::SampledHistogram(std::unique_ptr<Reservoir>&& reservoir,
+                                   std::uint32_t initial_interval,
+                                   std::uint64_t budget_per_second,
+                                   Clock* clock)
+    : m_sampler(initial_interval, budget_per_second, clock)
+    , m_count()
+    , m_recorded()
+    , m_reservoir(std::move(reservoir))
+{}
+
+void SampledHistogram::update(long value)
+{
+  m_count.incr();
+  if (auto weight = m_sampler.sample())
+  {
+    m_recorded.incr();
+    m_reservoir->update_weighted(value, weight);
+  }
+}
+
+long SampledHistogram::get_count() const noexcept
+{
+  return m_count.count();
+}
+
+long SampledHistogram::get_recorded_count() const noexcept
+{
+  return m_recorded.count();
+}
+
+std::uint32_t SampledHistogram::get_sample_interval() const noexcept
+{
+  return m_sampler.get_interval();
+}
+
+std::shared_ptr<Snapshot> SampledHistogram::get_snapshot()
+{
+  return m_reservoir->get_snapshot();
+}
+
+std::size_t SampledHistogram::memory_usage() const noexcept
+{
+  return sizeof(SampledHistogram)
+      + MemoryUsage::Owned(m_count)
+      + MemoryUsage::Owned(m_recorded)
+      + m_reservoir->memory_usage();
+}
+
+}
@@ -0,0 +1,108 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/SampledTimer.h>
+
+#include <utility>
+
+#include <metrics/Clock.h>
+
+#include "MemoryUsage.h"
+
+namespace cppmetrics {
+
+SampledTimer::SampledTimer(std::unique_ptr<Reservoir>&& reservoir, std::uint32_t interval, Clock* clock)
+    : m_sampler(interval)
+    , m_timer(std::move(reservoir), clock)
+{}
+
+SampledTimer::SampledTimer(std::unique_ptr<Reservoir>&& reservoir,
+                           std::uint32_t initial_interval,
+                           std::uint64_t budget_per_second,
+                           Clock* clock)
+    : m_sampler(initial_interval, budget_per_second, clock)
+    , m_timer(std::move(reservoir), clock)
+{}
+
+void SampledTimer::update(const std::chrono::nanoseconds& nanos)
+{
+  if (nanos.count() < 0)
+  {
+    return;
+  }
+
+  m_timer.count();
+  if (auto weight = m_sampler.sample())
+  {
+    m_timer.record(nanos, weight);
+  }
+}
+
+long SampledTimer::get_count() const noexcept
+{
+  return m_timer.get_count();
+}
+
+std::uint32_t SampledTimer::get_sample_interval() const noexcept
+{
+  return m_sampler.get_interval();
+}
+
+double SampledTimer::get_m1_rate()
+{
+  return m_timer.get_m1_rate();
+}
+
+double SampledTimer::get_m5_rate()
+{
+  return m_timer.get_m5_rate();
+}
+
+double SampledTimer::get_m15_rate()
+{
+  return m_timer.get_m15_rate();
+}
+
+double SampledTimer::get_mean_rate()
+{
+  return m_timer.get_mean_rate();
+}
+
+std::shared_ptr<Snapshot> SampledTimer::get_snapshot()
+{
+  return m_timer.get_snapshot();
+}
+
+std::size_t SampledTimer::memory_usage() const noexcept
+{
+  return sizeof(SampledTimer) + MemoryUsage::Owned(m_timer);
+}
+
+SampledTimer::Scope::Scope(SampledTimer& timer)
+    : m_timer(timer)
+    , m_weight(timer.m_sampler.sample())
+    , m_start(m_weight != 0 ? timer.m_timer.m_clock->tick() : std::chrono::nanoseconds::zero())
+{
+  m_timer.m_timer.count();
+}
+
+SampledTimer::Scope::~Scope()
+{
+  if (m_weight != 0)
+  {
+    m_timer.m_timer.record(m_timer.m_timer.m_clock->tick() - m_start, m_weight);
+  }
+}
+
+}
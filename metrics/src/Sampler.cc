@@ -0,0 +1,209 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/Sampler.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <metrics/Clock.h>
+
+namespace cppmetrics {
+
+namespace {
+
+constexpr std::int64_t kWindowNanos = 1000000000LL;
+
+// Hands out sampler ids, lowest free first, so that they stay dense.
+class IdAllocator
+{
+public:
+  std::size_t acquire()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_free.empty())
+    {
+      return m_next++;
+    }
+
+    std::pop_heap(m_free.begin(), m_free.end(), std::greater<std::size_t>());
+    std::size_t id = m_free.back();
+    m_free.pop_back();
+    return id;
+  }
+
+  void release(std::size_t id)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_free.push_back(id);
+    std::push_heap(m_free.begin(), m_free.end(), std::greater<std::size_t>());
+  }
+
+private:
+  std::mutex m_mutex;
+  std::size_t m_next = 0;
+  std::vector<std::size_t> m_free;
+};
+
+IdAllocator& GetIdAllocator()
+{
+  // Never destroyed; samplers with static storage may outlive it otherwise.
+  static IdAllocator* allocator = new IdAllocator();
+  return *allocator;
+}
+
+// Distinguishes the successive samplers that hold a reused id.
+std::atomic<std::uint64_t> gNextOwner{1};
+
+struct Countdown
+{
+  std::uint64_t owner;
+  std::uint32_t remaining;
+};
+
+// Indexed by sampler id.  An entry left by an id's previous owner is
+// reset on first use, so every thread samples its first event for each
+// sampler.
+thread_local std::vector<Countdown> tCountdowns;
+
+}
+
+const std::uint32_t Sampler::kMaxInterval = 1u << 20;
+
+Sampler::Sampler(std::uint32_t interval)
+    : m_id(GetIdAllocator().acquire())
+    , m_owner(gNextOwner.fetch_add(1, std::memory_order_relaxed))
+    , m_interval(std::min(std::max(interval, 1u), kMaxInterval))
+    , m_budget(0)
+    , m_clock(nullptr)
+    , m_window_start(0)
+    , m_window_samples(0)
+{}
+
+Sampler::Sampler(std::uint32_t initial_interval, std::uint64_t budget_per_second, Clock* clock)
+    : Sampler(initial_interval)
+{
+  m_budget = budget_per_second;
+  m_clock = clock != nullptr ? clock : GetDefaultClock();
+  m_window_start.store(m_clock->tick().count());
+}
+
+Sampler::~Sampler()
+{
+  GetIdAllocator().release(m_id);
+}
+
+bool Sampler::should_sample() noexcept
+{
+  return sample() != 0;
+}
+
+std::uint32_t Sampler::sample() noexcept
+{
+  auto& remaining = countdown();
+  if (remaining > 1)
+  {
+    --remaining;
+    return 0;
+  }
+
+  auto interval = m_interval.load(std::memory_order_relaxed);
+  remaining = interval;
+  if (m_budget != 0)
+  {
+    adapt();
+  }
+  return interval;
+}
+
+std::uint32_t& Sampler::countdown() noexcept
+{
+  if (m_id < tCountdowns.size())
+  {
+    auto& entry = tCountdowns[m_id];
+    if (entry.owner != m_owner)
+    {
+      entry.owner = m_owner;
+      entry.remaining = 0;
+    }
+    return entry.remaining;
+  }
+  return grow_countdowns();
+}
+
+std::uint32_t& Sampler::grow_countdowns() noexcept
+{
+  try
+  {
+    tCountdowns.resize(std::max(m_id + 1, tCountdowns.size() * 2), Countdown{0, 0});
+    tCountdowns[m_id].owner = m_owner;
+    return tCountdowns[m_id].remaining;
+  }
+  catch (...)
+  {
+    // Without room for a countdown, sample everything.
+    thread_local std::uint32_t always_sample;
+    always_sample = 0;
+    return always_sample;
+  }
+}
+
+std::uint32_t Sampler::get_interval() const noexcept
+{
+  return m_interval.load(std::memory_order_relaxed);
+}
+
+bool Sampler::is_adaptive() const noexcept
+{
+  return m_budget != 0;
+}
+
+void Sampler::adapt() noexcept
+{
+  auto samples = m_window_samples.fetch_add(1, std::memory_order_relaxed) + 1;
+  auto start = m_window_start.load(std::memory_order_relaxed);
+  auto now = m_clock->tick().count();
+  auto elapsed = now - start;
+
+  auto interval = m_interval.load(std::memory_order_relaxed);
+  std::uint32_t next = interval;
+  if (samples > m_budget)
+  {
+    // Over budget before the second is even up.
+    next = std::min(interval * 2, kMaxInterval);
+  }
+  else if (elapsed >= kWindowNanos)
+  {
+    if (samples * 4 < m_budget)
+    {
+      next = std::max(interval / 2, 1u);
+    }
+  }
+  else
+  {
+    return;
+  }
+
+  // One thread closes the window; the others just keep sampling.
+  if (m_window_start.compare_exchange_strong(start, now, std::memory_order_relaxed))
+  {
+    m_window_samples.store(0, std::memory_order_relaxed);
+    m_interval.store(next, std::memory_order_relaxed);
+  }
+}
+
+}
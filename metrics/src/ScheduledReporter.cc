@@ -17,6 +17,7 @@
 #include <utility>
 
 #include <metrics/Registry.h>
+#include <metrics/SelfMetrics.h>
 
 namespace cppmetrics {
 
@@ -58,12 +59,12 @@ void ScheduledReporter::loop_while_running()
 {
   while (true)
   {
-    auto start = std::chrono::system_clock::now();
+    auto start = std::chrono::steady_clock::now();
     auto next_report_time = start + m_interval;
 
     std::unique_lock<std::mutex> lock(m_mutex);
 
-    while (m_is_running && next_report_time > std::chrono::system_clock::now())
+    while (m_is_running && next_report_time > std::chrono::steady_clock::now())
     {
       m_cv.wait_until(lock, next_report_time, [&]() {
         // Predicate returns 'false' if waiting should continue.
@@ -85,6 +86,7 @@ void ScheduledReporter::loop_while_running()
 
 void ScheduledReporter::report()
 {
+  SelfMetrics::Scope pass(SelfMetrics::Duration::ReporterPass);
   m_reporter->report();
 }
 
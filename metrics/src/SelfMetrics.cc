@@ -0,0 +1,180 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/SelfMetrics.h>
+
+#include <metrics/Clock.h>
+#include <metrics/Counter.h>
+#include <metrics/ExponentiallyDecayingReservoir.h>
+#include <metrics/Timer.h>
+
+namespace cppmetrics {
+
+namespace {
+
+constexpr std::size_t kCounts = 4;
+constexpr std::size_t kDurations = 4;
+
+// Indexed by Count and Duration, respectively.
+const char* const kCountNames[kCounts] = {
+  "long_adder.cas_failures",
+  "long_adder.rehashes",
+  "registry.lookups",
+  "registry.creations",
+};
+
+const char* const kDurationNames[kDurations] = {
+  "reporter.report",
+  "snapshot.build",
+  "reservoir.rescale",
+  "reservoir.lock_wait",
+};
+
+struct State
+{
+  explicit State(Clock* clock)
+  {
+    for (auto&& counter : counters)
+    {
+      counter = std::make_shared<Counter>();
+    }
+    for (auto&& timer : timers)
+    {
+      timer = std::make_shared<Timer>(
+          std::make_unique<ExponentiallyDecayingReservoir>(
+              ExponentiallyDecayingReservoir::kDefaultSize,
+              ExponentiallyDecayingReservoir::kDefaultAlpha,
+              clock), clock);
+    }
+  }
+
+  std::shared_ptr<Counter> counters[kCounts];
+  std::shared_ptr<Timer> timers[kDurations];
+};
+
+State& GetState(Clock* clock)
+{
+  // Never destroyed; instrumented code may still run during static
+  // destruction.
+  static State* state = new State(clock);
+  return *state;
+}
+
+// Set while recording a self metric, whose own instrumented paths
+// would otherwise record into self metrics in turn.
+thread_local bool t_recording = false;
+
+class RecordingGuard
+{
+public:
+  RecordingGuard() noexcept
+    : m_entered(!t_recording)
+  {
+    t_recording = true;
+  }
+
+  ~RecordingGuard()
+  {
+    if (m_entered)
+    {
+      t_recording = false;
+    }
+  }
+
+  bool entered() const noexcept
+  {
+    return m_entered;
+  }
+
+private:
+  bool m_entered;
+};
+
+} // namespace
+
+std::atomic_bool SelfMetrics::s_enabled{false};
+std::atomic<Clock*> SelfMetrics::s_clock{nullptr};
+
+void SelfMetrics::set_clock(Clock* clock) noexcept
+{
+  s_clock.store(clock);
+}
+
+void SelfMetrics::set_enabled(bool enabled) noexcept
+{
+  if (enabled)
+  {
+    // Build the metrics before anything can try to record into them.
+    GetState(s_clock.load());
+  }
+  s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void SelfMetrics::count(Count which, long n) noexcept
+{
+  RecordingGuard guard;
+  if (!guard.entered() || !is_enabled())
+  {
+    return;
+  }
+
+  try
+  {
+    GetState(s_clock.load()).counters[static_cast<std::size_t>(which)]->inc(n);
+  }
+  catch (...)
+  {
+    // Losing a sample beats failing the operation being measured.
+  }
+}
+
+void SelfMetrics::record(Duration which, const std::chrono::nanoseconds& elapsed) noexcept
+{
+  RecordingGuard guard;
+  if (!guard.entered() || !is_enabled())
+  {
+    return;
+  }
+
+  try
+  {
+    GetState(s_clock.load()).timers[static_cast<std::size_t>(which)]->update(elapsed);
+  }
+  catch (...)
+  {
+    // As above.
+  }
+}
+
+std::vector<std::pair<std::string, std::shared_ptr<Counter>>> SelfMetrics::get_counters()
+{
+  std::vector<std::pair<std::string, std::shared_ptr<Counter>>> result;
+  for (std::size_t i = 0; i < kCounts; ++i)
+  {
+    result.emplace_back(kCountNames[i], GetState(s_clock.load()).counters[i]);
+  }
+  return result;
+}
+
+std::vector<std::pair<std::string, std::shared_ptr<Timer>>> SelfMetrics::get_timers()
+{
+  std::vector<std::pair<std::string, std::shared_ptr<Timer>>> result;
+  for (std::size_t i = 0; i < kDurations; ++i)
+  {
+    result.emplace_back(kDurationNames[i], GetState(s_clock.load()).timers[i]);
+  }
+  return result;
+}
+
+}
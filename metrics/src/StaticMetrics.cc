@@ -0,0 +1,42 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/StaticMetrics.h>
+
+#include <atomic>
+
+namespace cppmetrics {
+
+namespace {
+
+// Constant-initialized, so it is ready before any dynamic initializer runs.
+std::atomic<StaticMetricBase*> gHead{nullptr};
+
+}
+
+StaticMetricBase* StaticMetricBase::head() noexcept
+{
+  return gHead.load(std::memory_order_acquire);
+}
+
+void StaticMetricBase::link() noexcept
+{
+  StaticMetricBase* expected = gHead.load(std::memory_order_relaxed);
+  do
+  {
+    m_next = expected;
+  } while (!gHead.compare_exchange_weak(expected, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+}
@@ -14,27 +14,40 @@
 
 #include <metrics/Timer.h>
 
+#include <algorithm>
+#include <iterator>
 #include <utility>
 
 #include <metrics/ExponentiallyDecayingReservoir.h>
 
+#include "MemoryUsage.h"
+
 namespace cppmetrics {
 
-Timer::Timer()
-    : Timer(std::make_unique<ExponentiallyDecayingReservoir>())
+template <typename ClockPolicy>
+BasicTimer<ClockPolicy>::BasicTimer()
+    : BasicTimer(std::make_unique<ExponentiallyDecayingReservoir>())
+{}
+
+template <typename ClockPolicy>
+BasicTimer<ClockPolicy>::BasicTimer(std::unique_ptr<Reservoir>&& reservoir)
+    : BasicTimer(std::move(reservoir), ClockPolicy())
 {}
 
-Timer::Timer(std::unique_ptr<Reservoir>&& reservoir)
-    : Timer(std::move(reservoir), GetDefaultClock())
+template <typename ClockPolicy>
+BasicTimer<ClockPolicy>::BasicTimer(std::unique_ptr<Reservoir>&& reservoir, ClockPolicy clock)
+    : BasicTimer(std::move(reservoir), clock, ClockPolicy())
 {}
 
-Timer::Timer(std::unique_ptr<Reservoir>&& reservoir, Clock* clock)
+template <typename ClockPolicy>
+BasicTimer<ClockPolicy>::BasicTimer(std::unique_ptr<Reservoir>&& reservoir, ClockPolicy clock, ClockPolicy rate_clock)
     : m_clock(clock)
     , m_histogram(std::move(reservoir))
-    , m_meter()
+    , m_meter(rate_clock)
 {}
 
-void Timer::update(const std::chrono::nanoseconds& nanos)
+template <typename ClockPolicy>
+void BasicTimer<ClockPolicy>::update(const std::chrono::nanoseconds& nanos)
 {
   if (nanos.count() >= 0)
   {
@@ -43,38 +56,80 @@ void Timer::update(const std::chrono::nanoseconds& nanos)
   }
 }
 
-void Timer::update(const std::chrono::milliseconds& millis)
+template <typename ClockPolicy>
+void BasicTimer<ClockPolicy>::update(const std::chrono::milliseconds& millis)
 {
   update(std::chrono::duration_cast<std::chrono::nanoseconds>(millis));
 }
 
-long Timer::get_count()
+template <typename ClockPolicy>
+void BasicTimer<ClockPolicy>::update_batch(const long* nanos, std::size_t n)
+{
+  if (std::all_of(nanos, nanos + n, [](long value) { return value >= 0; }))
+  {
+    m_meter.mark(static_cast<long>(n));
+    m_histogram.update_batch(nanos, n);
+    return;
+  }
+
+  std::vector<long> valid;
+  valid.reserve(n);
+  std::copy_if(nanos, nanos + n, std::back_inserter(valid), [](long value) { return value >= 0; });
+  m_meter.mark(static_cast<long>(valid.size()));
+  m_histogram.update_batch(valid.data(), valid.size());
+}
+
+template <typename ClockPolicy>
+long BasicTimer<ClockPolicy>::get_count()
 {
   return m_meter.get_count();
 }
 
-double Timer::get_m1_rate()
+template <typename ClockPolicy>
+double BasicTimer<ClockPolicy>::get_m1_rate()
 {
   return m_meter.get_m1_rate();
 }
-double Timer::get_m5_rate()
+template <typename ClockPolicy>
+double BasicTimer<ClockPolicy>::get_m5_rate()
 {
   return m_meter.get_m5_rate();
 }
 
-double Timer::get_m15_rate()
+template <typename ClockPolicy>
+double BasicTimer<ClockPolicy>::get_m15_rate()
 {
   return m_meter.get_m15_rate();
 }
 
-double Timer::get_mean_rate()
+template <typename ClockPolicy>
+double BasicTimer<ClockPolicy>::get_mean_rate()
 {
   return m_meter.get_mean_rate();
 }
 
-std::shared_ptr<Snapshot> Timer::get_snapshot()
+template <typename ClockPolicy>
+std::shared_ptr<Snapshot> BasicTimer<ClockPolicy>::get_snapshot()
 {
   return m_histogram.get_snapshot();
 }
 
+template <typename ClockPolicy>
+Epoch::value_t BasicTimer<ClockPolicy>::last_update_epoch() const noexcept
+{
+  // Every update marks the meter, so its stamp speaks for the whole timer.
+  return m_meter.last_update_epoch();
+}
+
+template <typename ClockPolicy>
+std::size_t BasicTimer<ClockPolicy>::memory_usage() const noexcept
+{
+  return sizeof(BasicTimer)
+      + MemoryUsage::Owned(m_histogram)
+      + MemoryUsage::Owned(m_meter);
+}
+
+template class BasicTimer<ClockRef>;
+template class BasicTimer<SteadyClockPolicy>;
+
 } // namespace cppmetrics
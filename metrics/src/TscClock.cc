@@ -0,0 +1,216 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/TscClock.h>
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CPPMETRICS_TSC_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+#elif defined(__aarch64__)
+#define CPPMETRICS_TSC_ARM64 1
+#endif
+
+#if !defined(_WIN32)
+#include <time.h>
+#endif
+
+namespace cppmetrics {
+
+namespace {
+
+// Long enough that clock_gettime's own jitter is noise, short enough
+// that nobody notices the constructor blocking.
+constexpr std::chrono::milliseconds kCalibrationPeriod{10};
+
+std::int64_t read_counter() noexcept
+{
+#if defined(CPPMETRICS_TSC_X86)
+  return static_cast<std::int64_t>(__rdtsc());
+#elif defined(CPPMETRICS_TSC_ARM64)
+  std::uint64_t value;
+  asm volatile("isb; mrs %0, cntvct_el0" : "=r"(value) :: "memory");
+  return static_cast<std::int64_t>(value);
+#else
+  return 0;
+#endif
+}
+
+bool has_invariant_counter() noexcept
+{
+#if defined(CPPMETRICS_TSC_X86)
+  // CPUID.80000007H:EDX[8] - "Invariant TSC".
+#if defined(_MSC_VER)
+  int regs[4];
+  __cpuid(regs, 0x80000000);
+  if (static_cast<unsigned>(regs[0]) < 0x80000007)
+  {
+    return false;
+  }
+  __cpuid(regs, 0x80000007);
+  return (regs[3] & (1 << 8)) != 0;
+#else
+  unsigned eax, ebx, ecx, edx;
+  if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007)
+  {
+    return false;
+  }
+  __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+  return (edx & (1u << 8)) != 0;
+#endif
+#elif defined(CPPMETRICS_TSC_ARM64)
+  // The generic timer runs at a fixed frequency by definition.
+  return true;
+#else
+  return false;
+#endif
+}
+
+std::int64_t monotonic_nanos() noexcept
+{
+#if defined(_WIN32)
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+#else
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<std::int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+}
+
+TscClock::TscClock(const std::chrono::nanoseconds& recalibration_interval)
+    : m_supported(is_supported())
+    , m_recalibration_interval(recalibration_interval)
+    , m_anchor_ticks(0)
+    , m_anchor_nanos(0)
+    , m_sequence(0)
+    , m_base_ticks(0)
+    , m_base_nanos(0)
+    , m_nanos_per_tick(0.0)
+    , m_next_recalibration(std::numeric_limits<std::int64_t>::max())
+{
+  if (m_supported)
+  {
+    calibrate();
+  }
+}
+
+bool TscClock::is_supported() noexcept
+{
+  static const bool supported = has_invariant_counter();
+  return supported;
+}
+
+std::chrono::nanoseconds TscClock::tick()
+{
+  if (!m_supported)
+  {
+    return std::chrono::nanoseconds(monotonic_nanos());
+  }
+
+  auto ticks = read_counter();
+
+  auto next = m_next_recalibration.load(std::memory_order_relaxed);
+  if (ticks >= next)
+  {
+    // Whoever wins the exchange recalibrates; everyone else carries on
+    // with the current calibration.
+    if (m_next_recalibration.compare_exchange_strong(next, std::numeric_limits<std::int64_t>::max()))
+    {
+      recalibrate(ticks);
+    }
+  }
+
+  auto calibration = load_calibration();
+  auto elapsed = static_cast<double>(ticks - calibration.ticks) * calibration.nanos_per_tick;
+  return std::chrono::nanoseconds(calibration.nanos + static_cast<std::int64_t>(elapsed));
+}
+
+void TscClock::calibrate()
+{
+  m_anchor_ticks = read_counter();
+  m_anchor_nanos = monotonic_nanos();
+
+  std::this_thread::sleep_for(kCalibrationPeriod);
+
+  auto ticks = read_counter();
+  auto nanos = monotonic_nanos();
+  auto nanos_per_tick = static_cast<double>(nanos - m_anchor_nanos) / (ticks - m_anchor_ticks);
+
+  store_calibration({ ticks, nanos, nanos_per_tick });
+  m_next_recalibration.store(ticks + static_cast<std::int64_t>(m_recalibration_interval.count() / nanos_per_tick));
+}
+
+void TscClock::recalibrate(std::int64_t ticks)
+{
+  auto current = load_calibration();
+  auto nanos = monotonic_nanos();
+
+  // Never step: continue from where the current calibration says we
+  // are, and fold whatever error has accumulated into the rate so that
+  // it is slewed out over the next interval.
+  auto estimate = current.nanos + static_cast<std::int64_t>((ticks - current.ticks) * current.nanos_per_tick);
+  auto measured = static_cast<double>(nanos - m_anchor_nanos) / (ticks - m_anchor_ticks);
+  auto interval_ticks = m_recalibration_interval.count() / measured;
+  auto corrected = measured + (nanos - estimate) / interval_ticks;
+  corrected = std::min(std::max(corrected, measured * 0.5), measured * 1.5);
+
+  store_calibration({ ticks, estimate, corrected });
+  m_next_recalibration.store(ticks + static_cast<std::int64_t>(interval_ticks));
+}
+
+TscClock::Calibration TscClock::load_calibration() const noexcept
+{
+  Calibration result;
+  std::uint32_t before, after;
+  do
+  {
+    before = m_sequence.load(std::memory_order_acquire);
+    result.ticks = m_base_ticks.load(std::memory_order_relaxed);
+    result.nanos = m_base_nanos.load(std::memory_order_relaxed);
+    result.nanos_per_tick = m_nanos_per_tick.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    after = m_sequence.load(std::memory_order_relaxed);
+  } while ((before & 1) != 0 || before != after);
+  return result;
+}
+
+void TscClock::store_calibration(const Calibration& calibration) noexcept
+{
+  auto sequence = m_sequence.load(std::memory_order_relaxed);
+  m_sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  m_base_ticks.store(calibration.ticks, std::memory_order_relaxed);
+  m_base_nanos.store(calibration.nanos, std::memory_order_relaxed);
+  m_nanos_per_tick.store(calibration.nanos_per_tick, std::memory_order_relaxed);
+  m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+Clock* GetTscClock()
+{
+  static Clock* gTscClock = new TscClock;
+  return gTscClock;
+}
+
+}
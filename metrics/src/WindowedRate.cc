@@ -0,0 +1,159 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/WindowedRate.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+#include <metrics/Clock.h>
+
+#include "MemoryUsage.h"
+
+namespace cppmetrics {
+
+namespace {
+
+std::int64_t current_second(Clock* clock)
+{
+  return std::chrono::duration_cast<std::chrono::seconds>(clock->tick()).count();
+}
+
+}
+
+WindowedRate::WindowedRate(const std::chrono::seconds& horizon, Clock* clock)
+    : m_clock(clock != nullptr ? clock : GetDefaultClock())
+    , m_horizon(horizon.count())
+    , m_slot_count(horizon.count() + 1)
+    , m_total()
+    , m_current_second(current_second(m_clock))
+    , m_published_second(m_current_second.load())
+    , m_snapshots()
+{
+  if (m_horizon <= 0)
+  {
+    throw std::invalid_argument{"WindowedRate needs a horizon of at least one second"};
+  }
+
+  m_snapshots.reset(new std::atomic<LongAdder::value_t>[m_slot_count]);
+  for (std::int64_t i = 0; i < m_slot_count; ++i)
+  {
+    m_snapshots[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void WindowedRate::mark(long n)
+{
+  rotate_if_necessary();
+  m_total.incr(n);
+}
+
+long WindowedRate::get_count() const noexcept
+{
+  return m_total.count();
+}
+
+double WindowedRate::get_rate(const std::chrono::seconds& window)
+{
+  auto n = window.count();
+  if (n <= 0 || n > m_horizon)
+  {
+    throw std::invalid_argument{"Window must be between one second and the horizon"};
+  }
+
+  rotate_if_necessary();
+
+  // A rotation can overwrite the oldest slot we need - it aliases the
+  // next second - so read like a seqlock: only trust the slots if no
+  // rotation was claimed or in flight while we read them.
+  while (true)
+  {
+    auto claimed = m_current_second.load(std::memory_order_acquire);
+    auto now = m_published_second.load(std::memory_order_acquire);
+    if (now == claimed)
+    {
+      auto marks = slot(now).load(std::memory_order_relaxed) - slot(now - n).load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (m_current_second.load(std::memory_order_relaxed) == claimed)
+      {
+        return static_cast<double>(marks) / n;
+      }
+    }
+    std::this_thread::yield();
+  }
+}
+
+double WindowedRate::get_rate()
+{
+  return get_rate(get_horizon());
+}
+
+std::chrono::seconds WindowedRate::get_horizon() const noexcept
+{
+  return std::chrono::seconds(m_horizon);
+}
+
+std::size_t WindowedRate::memory_usage() const noexcept
+{
+  return sizeof(WindowedRate)
+      + MemoryUsage::Owned(m_total)
+      + static_cast<std::size_t>(m_slot_count) * sizeof(std::atomic<LongAdder::value_t>);
+}
+
+void WindowedRate::rotate_if_necessary()
+{
+  auto old_second = m_current_second.load();
+  auto new_second = current_second(m_clock);
+  if (new_second <= old_second)
+  {
+    return;
+  }
+
+  if (m_current_second.compare_exchange_strong(old_second, new_second))
+  {
+    // Orders the claim before the slot writes, for get_rate().
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // Nothing was marked in any second we skipped over, so every
+    // boundary since the last rotation saw the same total.  Marks that
+    // race with this read are attributed to the second just ended.
+    auto total = m_total.count();
+    auto elapsed = std::min(new_second - old_second, m_slot_count);
+    for (auto s = new_second - elapsed + 1; s <= new_second; ++s)
+    {
+      slot(s).store(total, std::memory_order_relaxed);
+    }
+
+    // A later rotation may have overtaken this one; never publish
+    // backwards.
+    auto published = m_published_second.load(std::memory_order_relaxed);
+    while (published < new_second
+        && !m_published_second.compare_exchange_weak(published, new_second, std::memory_order_release))
+    {
+    }
+  }
+}
+
+std::atomic<LongAdder::value_t>& WindowedRate::slot(std::int64_t second) noexcept
+{
+  auto index = second % m_slot_count;
+  if (index < 0)
+  {
+    index += m_slot_count;
+  }
+  return m_snapshots[index];
+}
+
+}
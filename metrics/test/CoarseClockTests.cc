@@ -0,0 +1,137 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/CoarseClock.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include <metrics/Meter.h>
+
+#ifndef BENCH
+
+#include "gtest/gtest.h"
+
+namespace cppmetrics {
+
+using namespace std::chrono_literals;
+
+// Like ManualClock, but safe to read from the refresh thread.
+class SteppedClock : public Clock
+{
+public:
+  std::chrono::nanoseconds tick() override
+  {
+    return std::chrono::nanoseconds(m_now.load());
+  }
+
+  time_t now_as_time_t() override
+  {
+    return static_cast<time_t>(std::chrono::duration_cast<std::chrono::seconds>(tick()).count());
+  }
+
+  void add_seconds(int seconds)
+  {
+    m_now += std::chrono::nanoseconds(std::chrono::seconds(seconds)).count();
+  }
+
+private:
+  std::atomic<long long> m_now{0};
+};
+
+template <typename Predicate>
+bool eventually(Predicate&& predicate)
+{
+  auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (std::chrono::steady_clock::now() < deadline)
+  {
+    if (predicate())
+    {
+      return true;
+    }
+    std::this_thread::sleep_for(1ms);
+  }
+  return false;
+}
+
+TEST(CoarseClockTests, starts_at_the_source_time)
+{
+  SteppedClock source;
+  source.add_seconds(42);
+
+  CoarseClock clock{&source, 1ms};
+  EXPECT_EQ(std::chrono::nanoseconds(42s), clock.tick());
+  EXPECT_EQ(42, clock.now_as_time_t());
+  EXPECT_EQ(std::chrono::nanoseconds(1ms), clock.get_resolution());
+}
+
+TEST(CoarseClockTests, follows_the_source)
+{
+  SteppedClock source;
+  CoarseClock clock{&source, 1ms};
+
+  source.add_seconds(10);
+  EXPECT_TRUE(eventually([&]() { return clock.tick() == std::chrono::nanoseconds(10s); }));
+  EXPECT_TRUE(eventually([&]() { return clock.now_as_time_t() == 10; }));
+}
+
+TEST(CoarseClockTests, drives_meters)
+{
+  SteppedClock source;
+  CoarseClock clock{&source, 1ms};
+  Meter meter{&clock};
+
+  meter.mark(50);
+  source.add_seconds(6);
+  ASSERT_TRUE(eventually([&]() { return clock.tick() == std::chrono::nanoseconds(6s); }));
+  EXPECT_NEAR(10.0, meter.get_m1_rate(), 0.001);
+}
+
+TEST(CoarseClockTests, shared_instance)
+{
+  EXPECT_NE(nullptr, GetCoarseClock());
+  EXPECT_EQ(GetCoarseClock(), GetCoarseClock());
+}
+
+}
+
+#else
+
+int main(int argc, char** argv)
+{
+  using namespace cppmetrics;
+
+  constexpr const std::size_t numIters = 10000000;
+
+  auto bench = [&](const char* name, Clock* clock) {
+    Meter meter{clock};
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < numIters; ++i)
+    {
+      meter.mark();
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto nanos = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cerr << name << ": " << nanos / numIters << " ns/mark" << std::endl;
+  };
+
+  bench("default clock", GetDefaultClock());
+  bench("coarse clock", GetCoarseClock());
+
+  return 0;
+}
+
+#endif
@@ -0,0 +1,140 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+import com.codahale.metrics.Counter;
+import com.codahale.metrics.ExponentiallyDecayingReservoir;
+import com.codahale.metrics.Histogram;
+import com.codahale.metrics.Meter;
+
+import java.io.FileWriter;
+import java.io.PrintWriter;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.Locale;
+import java.util.concurrent.CyclicBarrier;
+
+/**
+ * The Dropwizard Metrics half of the parity benchmark; ParityBench.cc is
+ * the other half, and runs the same workloads the same way.  Each line of
+ * output is a workload and its best mean nanoseconds per operation.
+ *
+ * Usage: java -cp dropwizard_parity.jar:metrics-core.jar DropwizardParity [results-file]
+ */
+public class DropwizardParity {
+    // Keep these in step with ParityBench.cc.
+    static final long OPS_PER_THREAD = 2000000;
+    static final long SNAPSHOT_OPS = 2000;
+    static final int WARMUP_ROUNDS = 3;
+    static final int ROUNDS = 5;
+
+    interface Op {
+        void run(long i);
+    }
+
+    interface Workload {
+        Op create();
+    }
+
+    static volatile double sink;
+
+    static double nanosPerOp(final int threads, final long opsPerThread, final Op op) throws Exception {
+        final CyclicBarrier start = new CyclicBarrier(threads + 1);
+        final CyclicBarrier end = new CyclicBarrier(threads + 1);
+
+        List<Thread> workers = new ArrayList<>(threads);
+        for (int t = 0; t < threads; ++t) {
+            Thread worker = new Thread(() -> {
+                try {
+                    start.await();
+                    for (long i = 0; i < opsPerThread; ++i) {
+                        op.run(i);
+                    }
+                    end.await();
+                } catch (Exception e) {
+                    throw new RuntimeException(e);
+                }
+            });
+            worker.start();
+            workers.add(worker);
+        }
+
+        start.await();
+        long begin = System.nanoTime();
+        end.await();
+        long elapsed = System.nanoTime() - begin;
+
+        for (Thread worker : workers) {
+            worker.join();
+        }
+        return (double) elapsed / (opsPerThread * threads);
+    }
+
+    static double best(int threads, long opsPerThread, Workload workload) throws Exception {
+        for (int i = 0; i < WARMUP_ROUNDS; ++i) {
+            nanosPerOp(threads, opsPerThread, workload.create());
+        }
+
+        double best = Double.MAX_VALUE;
+        for (int i = 0; i < ROUNDS; ++i) {
+            best = Math.min(best, nanosPerOp(threads, opsPerThread, workload.create()));
+        }
+        return best;
+    }
+
+    public static void main(String[] args) throws Exception {
+        int cpus = Runtime.getRuntime().availableProcessors();
+        int[] threadCounts = cpus > 1 ? new int[] { 1, cpus } : new int[] { 1 };
+
+        List<String> results = new ArrayList<>();
+
+        for (int threads : threadCounts) {
+            results.add(line("counter.inc/" + threads, best(threads, OPS_PER_THREAD, () -> {
+                Counter counter = new Counter();
+                return i -> counter.inc();
+            })));
+
+            results.add(line("meter.mark/" + threads, best(threads, OPS_PER_THREAD, () -> {
+                Meter meter = new Meter();
+                return i -> meter.mark();
+            })));
+
+            results.add(line("histogram.update/" + threads, best(threads, OPS_PER_THREAD, () -> {
+                Histogram histogram = new Histogram(new ExponentiallyDecayingReservoir());
+                return i -> histogram.update(i & 1023);
+            })));
+        }
+
+        results.add(line("histogram.snapshot/1", best(1, SNAPSHOT_OPS, () -> {
+            Histogram histogram = new Histogram(new ExponentiallyDecayingReservoir());
+            for (long i = 0; i < 10000; ++i) {
+                histogram.update(i);
+            }
+            return i -> sink += histogram.getSnapshot().get99thPercentile();
+        })));
+
+        if (args.length > 0) {
+            try (PrintWriter out = new PrintWriter(new FileWriter(args[0]))) {
+                for (String result : results) {
+                    out.println(result);
+                }
+            }
+        }
+    }
+
+    static String line(String name, double nanos) {
+        String result = String.format(Locale.ROOT, "%s %.2f", name, nanos);
+        System.out.println(result);
+        return result;
+    }
+}
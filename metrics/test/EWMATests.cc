@@ -125,4 +125,98 @@ TEST(EWMATest, fifteen_minute_ewma_with_value_of_three)
   }
 }
 
+TEST(EWMATest, tick_n_of_zero_does_nothing)
+{
+  auto ewma = EWMA::one_minute();
+  ewma->update(3);
+  ewma->tick_n(0);
+
+  EXPECT_EQ(0.0, ewma->get_rate(std::chrono::seconds(1)));
+
+  ewma->tick();
+  EXPECT_FLOAT_EQ(0.6, ewma->get_rate(std::chrono::seconds(1)));
+}
+
+TEST(EWMATest, tick_n_matches_repeated_ticks)
+{
+  using Factory = std::shared_ptr<EWMA> (*)();
+  for (Factory factory : { &EWMA::one_minute, &EWMA::five_minutes, &EWMA::fifteen_minutes })
+  {
+    for (std::uint64_t ticks : { 1, 2, 12, 100, 1000 })
+    {
+      auto iterative = factory();
+      auto closed_form = factory();
+
+      // An established rate, then a pending count, then |ticks| ticks.
+      for (auto&& ewma : { iterative, closed_form })
+      {
+        ewma->update(30);
+        ewma->tick();
+        ewma->update(7);
+      }
+
+      for (std::uint64_t i = 0; i < ticks; ++i)
+      {
+        iterative->tick();
+      }
+      closed_form->tick_n(ticks);
+
+      auto expected = iterative->get_rate(std::chrono::seconds(1));
+      EXPECT_NEAR(expected, closed_form->get_rate(std::chrono::seconds(1)), 1e-9 + expected * 1e-9)
+          << ticks << " ticks";
+    }
+  }
+}
+
+TEST(EWMATest, tick_n_initializes_like_tick)
+{
+  auto iterative = EWMA::five_minutes();
+  auto closed_form = EWMA::five_minutes();
+
+  iterative->update(3);
+  closed_form->update(3);
+
+  // One tick to take in the update, then a minute's worth.
+  for (int i = 0; i < 13; ++i)
+  {
+    iterative->tick();
+  }
+  closed_form->tick_n(13);
+
+  EXPECT_NEAR(iterative->get_rate(std::chrono::seconds(1)), closed_form->get_rate(std::chrono::seconds(1)), 1e-12);
+  EXPECT_NEAR(0.49123845, closed_form->get_rate(std::chrono::seconds(1)), 0.000001);
+}
+
+TEST(EWMATest, tick_spread_matches_even_ticks)
+{
+  for (bool established : { false, true })
+  {
+    for (std::uint64_t ticks : { 1, 2, 12, 100 })
+    {
+      auto iterative = EWMA::one_minute();
+      auto closed_form = EWMA::one_minute();
+
+      if (established)
+      {
+        for (auto&& ewma : { iterative, closed_form })
+        {
+          ewma->update(300);
+          ewma->tick();
+        }
+      }
+
+      for (std::uint64_t i = 0; i < ticks; ++i)
+      {
+        iterative->update(20);
+        iterative->tick();
+      }
+      closed_form->tick_spread(static_cast<long>(20 * ticks), ticks);
+
+      auto expected = iterative->get_rate(std::chrono::seconds(1));
+      EXPECT_NEAR(expected, closed_form->get_rate(std::chrono::seconds(1)), 1e-9 + expected * 1e-9)
+          << ticks << " ticks";
+    }
+  }
+}
+
 }
@@ -194,4 +194,60 @@ TEST(EDRTest, quantiles_are_based_on_weights)
   EXPECT_EQ(9999, snapshot->get_p75());
 }
 
+TEST(EDRTest, weighted_updates_count_for_their_weight)
+{
+  ManualClock clock;
+  ExponentiallyDecayingReservoir reservoir(1000, 0.015, &clock);
+
+  for (int i = 0; i < 100; ++i)
+  {
+    reservoir.update(1);
+  }
+
+  for (int i = 0; i < 10; ++i)
+  {
+    reservoir.update_weighted(1000, 100);
+  }
+
+  // 100 events of 1 against 1000 events of 1000.
+  auto snapshot = reservoir.get_snapshot();
+  EXPECT_EQ(110, snapshot->size());
+  EXPECT_EQ(1000, snapshot->get_median());
+}
+
+// Ticks steadily, but its wall time can be stepped arbitrarily.
+class SteppedWallClock : public ManualClock
+{
+public:
+  time_t now_as_time_t() override
+  {
+    return ManualClock::now_as_time_t() + m_step;
+  }
+
+  void step_wall_time(time_t seconds)
+  {
+    m_step += seconds;
+  }
+
+private:
+  time_t m_step = 0;
+};
+
+TEST(EDRTest, wall_clock_steps_do_not_rescale)
+{
+  SteppedWallClock clock;
+  ExponentiallyDecayingReservoir reservoir(100, 0.99, &clock);
+
+  for (int i = 0; i < 10; ++i)
+  {
+    reservoir.update(i);
+  }
+
+  // A step this large would decay every existing sample to nothing.
+  clock.step_wall_time(24 * 60 * 60);
+  reservoir.update(10);
+
+  EXPECT_EQ(11, reservoir.get_snapshot()->size());
+}
+
 }
@@ -0,0 +1,135 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/Gauge.h>
+
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include <metrics/CachedGauge.h>
+#include <metrics/CallbackGauge.h>
+#include <metrics/Counter.h>
+#include <metrics/DerivativeGauge.h>
+#include <metrics/DoubleGauge.h>
+#include <metrics/RatioGauge.h>
+
+#include "ManualClock.h"
+
+namespace cppmetrics {
+
+TEST(GaugeTests, holds_the_last_value_set)
+{
+  Gauge gauge;
+  EXPECT_EQ(0, gauge.get());
+
+  gauge.set(12);
+  gauge.set(7);
+  EXPECT_EQ(7, gauge.get());
+}
+
+TEST(GaugeTests, callback_gauges_compute_on_every_read)
+{
+  int calls = 0;
+  CallbackGauge gauge{[&]() { return static_cast<long>(++calls * 10); }};
+  EXPECT_EQ(0, calls);
+
+  GaugeBase& base = gauge;
+  EXPECT_EQ(10, base.get());
+  EXPECT_EQ(20, base.get());
+  EXPECT_EQ(2, calls);
+}
+
+TEST(GaugeTests, callback_gauges_are_never_idle)
+{
+  CallbackGauge gauge{[]() { return 1L; }};
+
+  Epoch::advance();
+  EXPECT_EQ(Epoch::current(), gauge.last_update_epoch());
+}
+
+TEST(GaugeTests, cached_gauges_compute_at_most_once_per_ttl)
+{
+  ManualClock clock;
+  int calls = 0;
+  CachedGauge gauge{[&]() { return static_cast<long>(++calls); }, std::chrono::seconds(10), &clock};
+
+  EXPECT_EQ(1, gauge.get());
+  EXPECT_EQ(1, gauge.get());
+
+  clock.add_seconds(9);
+  EXPECT_EQ(1, gauge.get());
+
+  clock.add_seconds(1);
+  EXPECT_EQ(2, gauge.get());
+  EXPECT_EQ(2, calls);
+}
+
+TEST(GaugeTests, double_gauges_hold_fractions)
+{
+  DoubleGauge gauge;
+  EXPECT_EQ(0.0, gauge.get());
+
+  gauge.set(0.75);
+  EXPECT_EQ(0.75, gauge.get());
+}
+
+TEST(GaugeTests, ratio_gauges_divide_counters_when_read)
+{
+  auto hits = std::make_shared<Counter>();
+  auto lookups = std::make_shared<Counter>();
+  RatioGauge ratio{hits, lookups};
+
+  EXPECT_TRUE(std::isnan(ratio.get()));
+
+  hits->inc(3);
+  lookups->inc(4);
+  EXPECT_EQ(0.75, ratio.get());
+}
+
+TEST(GaugeTests, derivative_gauges_report_change_per_second)
+{
+  ManualClock clock;
+  auto counter = std::make_shared<Counter>();
+  DerivativeGauge gauge{counter, &clock};
+
+  counter->inc(100);
+  EXPECT_EQ(0.0, gauge.get());
+
+  counter->inc(50);
+  clock.add_seconds(10);
+  EXPECT_EQ(5.0, gauge.get());
+
+  // No time has passed, so there is no rate to speak of.
+  EXPECT_EQ(0.0, gauge.get());
+
+  clock.add_seconds(5);
+  EXPECT_EQ(0.0, gauge.get());
+}
+
+TEST(GaugeTests, derivative_gauges_can_follow_any_value)
+{
+  ManualClock clock;
+  double value = 10.0;
+  DerivativeGauge gauge{[&]() { return value; }, &clock};
+
+  gauge.get();
+  value = 4.0;
+  clock.add_seconds(2);
+  EXPECT_EQ(-3.0, gauge.get());
+}
+
+}
@@ -14,8 +14,48 @@
 
 #include <metrics/Histogram.h>
 
+#include <memory>
+#include <vector>
+
 #include "gtest/gtest.h"
 
+#include <metrics/ExponentiallyDecayingReservoir.h>
+#include <metrics/Snapshot.h>
+
 namespace cppmetrics {
 
+TEST(HistogramTests, counts_updates_not_values)
+{
+  Histogram histogram{std::make_unique<ExponentiallyDecayingReservoir>()};
+
+  histogram.update(100);
+  histogram.update(250);
+
+  EXPECT_EQ(2, histogram.get_count());
+}
+
+TEST(HistogramTests, update_batch_records_every_value)
+{
+  Histogram histogram{std::make_unique<ExponentiallyDecayingReservoir>()};
+
+  std::vector<long> values{ 5, 1, 4, 2, 3 };
+  histogram.update_batch(values.data(), values.size());
+
+  EXPECT_EQ(5, histogram.get_count());
+
+  auto snapshot = histogram.get_snapshot();
+  EXPECT_EQ(5u, snapshot->size());
+  EXPECT_EQ(1, snapshot->get_min());
+  EXPECT_EQ(5, snapshot->get_max());
+}
+
+TEST(HistogramTests, empty_batches_are_fine)
+{
+  Histogram histogram{std::make_unique<ExponentiallyDecayingReservoir>()};
+
+  histogram.update_batch(nullptr, 0);
+
+  EXPECT_EQ(0, histogram.get_count());
+}
+
 }
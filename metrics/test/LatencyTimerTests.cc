@@ -0,0 +1,162 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/LatencyTimer.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+#include <metrics/ExponentiallyDecayingReservoir.h>
+#include <metrics/Snapshot.h>
+
+#ifndef BENCH
+
+#include "gtest/gtest.h"
+
+#include "ManualClock.h"
+
+namespace cppmetrics {
+
+TEST(LatencyTimerTests, starts_with_zero_rates_and_count)
+{
+  ManualClock clock;
+  LatencyTimer timer(std::make_unique<ExponentiallyDecayingReservoir>(), &clock);
+
+  EXPECT_EQ(0, timer.get_count());
+  EXPECT_EQ(0.0, timer.get_m1_rate());
+  EXPECT_EQ(0.0, timer.get_m5_rate());
+  EXPECT_EQ(0.0, timer.get_m15_rate());
+  EXPECT_EQ(0.0, timer.get_mean_rate());
+}
+
+TEST(LatencyTimerTests, records_durations)
+{
+  ManualClock clock;
+  LatencyTimer timer(std::make_unique<ExponentiallyDecayingReservoir>(), &clock);
+
+  timer.update(std::chrono::milliseconds(3));
+  timer.update(std::chrono::nanoseconds(-1));
+
+  EXPECT_EQ(1, timer.get_count());
+  EXPECT_EQ(3000000, timer.get_snapshot()->get_max());
+}
+
+TEST(LatencyTimerTests, times_scopes)
+{
+  ManualClock clock;
+  LatencyTimer timer(std::make_unique<ExponentiallyDecayingReservoir>(), &clock);
+
+  auto result = timed(timer, [&]() {
+    clock.add_millis(20);
+    return 7;
+  });
+
+  EXPECT_EQ(7, result);
+  EXPECT_EQ(1, timer.get_count());
+  EXPECT_EQ(20000000, timer.get_snapshot()->get_max());
+}
+
+TEST(LatencyTimerTests, rates_are_derived_when_read)
+{
+  ManualClock clock;
+  LatencyTimer timer(std::make_unique<ExponentiallyDecayingReservoir>(), &clock);
+
+  for (int i = 0; i < 50; ++i)
+  {
+    timer.update(std::chrono::milliseconds(1));
+  }
+
+  clock.add_seconds(5);
+  EXPECT_NEAR(10.0, timer.get_m1_rate(), 0.001);
+  EXPECT_NEAR(10.0, timer.get_m15_rate(), 0.001);
+  EXPECT_NEAR(10.0, timer.get_mean_rate(), 0.001);
+
+  // Reading again without a new interval changes nothing.
+  EXPECT_NEAR(10.0, timer.get_m1_rate(), 0.001);
+
+  clock.add_minutes(5);
+  EXPECT_LT(timer.get_m1_rate(), 1.0);
+}
+
+TEST(LatencyTimerTests, infrequent_reads_see_steady_rates)
+{
+  ManualClock clock;
+  LatencyTimer timer(std::make_unique<ExponentiallyDecayingReservoir>(), &clock);
+
+  // 100 events a second, read once a minute.
+  for (int minute = 0; minute < 10; ++minute)
+  {
+    for (int i = 0; i < 6000; ++i)
+    {
+      timer.update(std::chrono::milliseconds(1));
+    }
+
+    clock.add_seconds(60);
+    EXPECT_NEAR(100.0, timer.get_m1_rate(), 0.001);
+    EXPECT_NEAR(100.0, timer.get_m5_rate(), 0.001);
+    EXPECT_NEAR(100.0, timer.get_m15_rate(), 0.001);
+  }
+}
+
+}
+
+#else
+
+#include <metrics/Timer.h>
+
+namespace {
+
+using namespace cppmetrics;
+
+// Isolates the per-sample overhead of the timers from the reservoir's.
+class NullReservoir : public Reservoir
+{
+public:
+  std::size_t size() const override { return 0; }
+  void update(long) override {}
+  std::shared_ptr<Snapshot> get_snapshot() override { return nullptr; }
+};
+
+template <typename T>
+void bench(const char* name, std::unique_ptr<Reservoir>&& reservoir, std::size_t numIters)
+{
+  T timer(std::move(reservoir));
+
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < numIters; ++i)
+  {
+    timer.update(std::chrono::nanoseconds(i & 0xFFFF));
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  auto nanos = std::chrono::duration<double, std::nano>(end - start).count();
+  std::cerr << name << ": " << nanos / numIters << " ns/update" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  constexpr const std::size_t numIters = 1000000;
+
+  bench<Timer>("Timer, null reservoir", std::make_unique<NullReservoir>(), numIters);
+  bench<LatencyTimer>("LatencyTimer, null reservoir", std::make_unique<NullReservoir>(), numIters);
+  bench<Timer>("Timer, EDR", std::make_unique<ExponentiallyDecayingReservoir>(), numIters);
+  bench<LatencyTimer>("LatencyTimer, EDR", std::make_unique<ExponentiallyDecayingReservoir>(), numIters);
+
+  return 0;
+}
+
+#endif
@@ -0,0 +1,267 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/CountingAllocator.h>
+#include <metrics/metrics.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef BENCH
+
+#include "gtest/gtest.h"
+
+namespace cppmetrics {
+
+TEST(MemoryUsageTests, counting_allocator_tracks_outstanding_bytes)
+{
+  std::vector<int, CountingAllocator<int>> values;
+  values.reserve(100);
+  EXPECT_EQ(100 * sizeof(int), values.get_allocator().bytes());
+
+  auto copy = values.get_allocator();
+  values.reserve(200);
+  EXPECT_EQ(200 * sizeof(int), copy.bytes());
+
+  values.clear();
+  values.shrink_to_fit();
+  EXPECT_EQ(0u, copy.bytes());
+}
+
+TEST(MemoryUsageTests, long_adder_counts_cells_as_they_are_allocated)
+{
+  LongAdder adder;
+  auto fresh = adder.memory_usage();
+  EXPECT_GE(fresh, sizeof(LongAdder));
+
+  adder.incr();
+  EXPECT_GT(adder.memory_usage(), fresh);
+}
+
+TEST(MemoryUsageTests, reservoir_grows_with_its_samples)
+{
+  ExponentiallyDecayingReservoir reservoir{100};
+  EXPECT_EQ(sizeof(ExponentiallyDecayingReservoir), reservoir.memory_usage());
+
+  for (long i = 0; i < 1000; ++i)
+  {
+    reservoir.update(i);
+  }
+  auto full = reservoir.memory_usage();
+  EXPECT_GE(full, sizeof(ExponentiallyDecayingReservoir) + 100 * sizeof(std::pair<const double, WeightedSample>));
+
+  ExponentiallyDecayingReservoir moved{std::move(reservoir)};
+  EXPECT_EQ(full, moved.memory_usage());
+  EXPECT_EQ(sizeof(ExponentiallyDecayingReservoir), reservoir.memory_usage());
+}
+
+TEST(MemoryUsageTests, composites_include_their_parts)
+{
+  Histogram histogram{std::make_unique<ExponentiallyDecayingReservoir>()};
+  EXPECT_EQ(sizeof(Histogram) + sizeof(ExponentiallyDecayingReservoir), histogram.memory_usage());
+
+  Meter meter;
+  EXPECT_GE(meter.memory_usage(), sizeof(Meter));
+  EXPECT_GE(sizeof(Meter), 3 * sizeof(EWMA));
+
+  Timer timer;
+  EXPECT_GE(timer.memory_usage(), sizeof(Timer) + sizeof(ExponentiallyDecayingReservoir));
+}
+
+TEST(MemoryUsageTests, meters_only_allocate_windows_beyond_their_inline_storage)
+{
+  using namespace std::chrono_literals;
+
+  Meter defaults;
+  Meter three{{1s, 2s, 3s}, 1s};
+  Meter four{{1s, 2s, 3s, 4s}, 1s};
+
+  EXPECT_EQ(defaults.memory_usage(), three.memory_usage());
+  EXPECT_GE(four.memory_usage(), three.memory_usage() + 4 * sizeof(EWMA));
+}
+
+TEST(MemoryUsageTests, one_window_meters_are_smaller_than_the_default)
+{
+  using namespace std::chrono_literals;
+
+  Meter defaults;
+  BasicMeter<ClockRef, 1> one{{1min}, 5s};
+
+  EXPECT_LT(sizeof(one), sizeof(defaults));
+  EXPECT_LE(one.memory_usage() + 2 * sizeof(EWMA), defaults.memory_usage());
+
+  // Past its inline storage, it allocates exactly what it needs.
+  BasicMeter<ClockRef, 1> two{{1min, 5min}, 5s};
+  EXPECT_LT(two.memory_usage(), one.memory_usage() + 3 * sizeof(EWMA) + 3 * sizeof(std::chrono::nanoseconds));
+}
+
+TEST(MemoryUsageTests, gauges_report_their_own_size)
+{
+  Gauge gauge;
+  CallbackGauge callback{[] { return 1L; }};
+  GaugeBase& base = callback;
+
+  EXPECT_EQ(sizeof(Gauge), gauge.memory_usage());
+  EXPECT_EQ(sizeof(CallbackGauge), base.memory_usage());
+}
+
+TEST(MemoryUsageTests, registry_accounts_for_each_metric)
+{
+  Registry registry;
+  auto empty = registry.memory_usage();
+
+  std::vector<std::string> names;
+  for (int i = 0; i < 100; ++i)
+  {
+    names.push_back("a.reasonably.long.metric.name." + std::to_string(i));
+  }
+  registry.register_all(MetricType::Counter, names);
+
+  auto full = registry.memory_usage();
+  EXPECT_GE(full - empty, 100 * (Counter().memory_usage() + names[0].size()));
+
+  for (auto&& name : names)
+  {
+    registry.remove(name);
+  }
+  EXPECT_EQ(empty, registry.memory_usage());
+}
+
+} // namespace cppmetrics
+
+#else
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using namespace cppmetrics;
+
+namespace {
+
+// What the allocator itself says is in use, as a check on memory_usage().
+// Zero where we have no way to ask.
+std::size_t heap_in_use()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  struct mallinfo2 info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+#else
+  return 0;
+#endif
+}
+
+void touch(Registry& registry, MetricType type, const std::string& name)
+{
+  switch (type)
+  {
+    case MetricType::Counter:   registry.counter(name)->inc(); break;
+    case MetricType::Meter:     registry.meter(name)->mark(); break;
+    case MetricType::Histogram: registry.histogram(name)->update(1); break;
+    case MetricType::Timer:     registry.timer(name)->update(std::chrono::milliseconds(1)); break;
+    default:                    registry.gauge(name)->set(1); break;
+  }
+}
+
+// memory_usage() leaves out malloc's per-block overhead, so it should
+// come in under malloc's count, but not so far under that whole
+// allocations must be going uncounted.
+constexpr double kMinHeapFraction = 0.6;
+
+bool plausible(double reported, double heap)
+{
+  return heap == 0 || (reported <= heap && reported >= heap * kMinHeapFraction);
+}
+
+// Prints one row of figures, and returns false if they disagree with malloc.
+bool measure(const char* label, MetricType type, std::size_t count)
+{
+  std::vector<std::string> names;
+  names.reserve(count);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    names.push_back("service.component.metric." + std::to_string(i));
+  }
+
+  auto heap_before = heap_in_use();
+  Registry registry;
+  registry.register_all(type, names);
+
+  double fresh = static_cast<double>(registry.memory_usage()) / count;
+  double fresh_heap = static_cast<double>(heap_in_use() - heap_before) / count;
+
+  for (auto&& name : names)
+  {
+    touch(registry, type, name);
+  }
+
+  double touched = static_cast<double>(registry.memory_usage()) / count;
+  double touched_heap = static_cast<double>(heap_in_use() - heap_before) / count;
+
+  std::cout << std::left << std::setw(11) << label
+            << std::right << std::setw(9) << count
+            << std::fixed << std::setprecision(1)
+            << std::setw(12) << fresh
+            << std::setw(12) << fresh_heap
+            << std::setw(12) << touched
+            << std::setw(12) << touched_heap;
+
+  bool ok = plausible(fresh, fresh_heap) && plausible(touched, touched_heap);
+  std::cout << (ok ? "" : "  MISMATCH") << std::endl;
+  return ok;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  // An optional argument caps the largest registry, for small machines.
+  std::size_t max = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+  std::cout << "Bytes per metric; 'heap' is malloc's own count, and includes\n"
+            << "allocator overhead that memory_usage() does not.  Exits non-zero\n"
+            << "if memory_usage() is above it, or below " << kMinHeapFraction << " of it.\n\n";
+  std::cout << std::left << std::setw(11) << "type"
+            << std::right << std::setw(9) << "metrics"
+            << std::setw(12) << "fresh" << std::setw(12) << "heap"
+            << std::setw(12) << "updated" << std::setw(12) << "heap" << std::endl;
+
+  const std::pair<const char*, MetricType> types[] = {
+    { "gauge",     MetricType::Gauge },
+    { "counter",   MetricType::Counter },
+    { "meter",     MetricType::Meter },
+    { "histogram", MetricType::Histogram },
+    { "timer",     MetricType::Timer },
+  };
+
+  int mismatches = 0;
+  for (auto&& type : types)
+  {
+    for (std::size_t count : { 1000u, 100000u, 1000000u })
+    {
+      if (count <= max && !measure(type.first, type.second, count))
+      {
+        ++mismatches;
+      }
+    }
+  }
+
+  return mismatches > 0 ? 1 : 0;
+}
+
+#endif
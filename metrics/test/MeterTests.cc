@@ -14,6 +14,14 @@
 
 #include <metrics/Meter.h>
 
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifndef BENCH
+
 #include "gtest/gtest.h"
 
 #include "ManualClock.h"
@@ -47,4 +55,195 @@ TEST(MeterTests, mark_updates_rates_and_counts)
   EXPECT_NEAR(0.1988, meter.get_m15_rate(), 0.001);
 }
 
+TEST(MeterTests, marks_from_many_threads_are_all_counted)
+{
+  ManualClock clock;
+  Meter meter{&clock};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t)
+  {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < 10000; ++i)
+      {
+        meter.mark();
+      }
+    });
+  }
+
+  for (auto&& t : threads)
+  {
+    t.join();
+  }
+
+  EXPECT_EQ(80000, meter.get_count());
+
+  // One tick later, the whole interval's worth reaches the averages.
+  clock.add_seconds(5);
+  clock.add_nanos(1);
+  EXPECT_NEAR(80000 / 5.0, meter.get_m1_rate(), 0.001);
+}
+
+TEST(MeterTests, catches_up_after_long_idle_periods)
+{
+  ManualClock clock;
+  Meter meter{&clock};
+
+  meter.mark(1000);
+  clock.add_seconds(5);
+  clock.add_nanos(1);
+  EXPECT_NEAR(200.0, meter.get_m1_rate(), 0.001);
+
+  // A month of idleness is a single closed-form step.
+  clock.add_hours(24 * 30);
+  EXPECT_NEAR(0.0, meter.get_m1_rate(), 1e-9);
+  EXPECT_NEAR(0.0, meter.get_m15_rate(), 1e-9);
+}
+
+TEST(MeterTests, externally_ticked_meters_only_tick_on_demand)
+{
+  ManualClock clock;
+  Meter meter{&clock};
+  meter.set_externally_ticked(true);
+
+  meter.mark(10);
+  clock.add_seconds(6);
+  meter.mark(10);
+
+  // No tick has happened yet, so the averages have seen nothing.
+  EXPECT_EQ(20, meter.get_count());
+  EXPECT_EQ(0.0, meter.get_m1_rate());
+
+  meter.tick();
+  EXPECT_NEAR(4.0, meter.get_m1_rate(), 0.001);
+
+  // Handing ticking back to the meter resumes lazy ticking.
+  meter.set_externally_ticked(false);
+  clock.add_seconds(5);
+  EXPECT_LT(meter.get_m1_rate(), 4.0);
+}
+
+TEST(MeterTests, custom_windows_and_tick_interval)
+{
+  using namespace std::chrono_literals;
+
+  ManualClock clock;
+  Meter meter{{1s, 10s}, 100ms, &clock};
+
+  EXPECT_EQ((std::vector<std::chrono::nanoseconds>{1s, 10s}), meter.get_windows());
+  EXPECT_EQ(std::chrono::nanoseconds{100ms}, meter.get_tick_interval());
+
+  meter.mark(100);
+  clock.add_millis(100);
+  clock.add_nanos(1);
+  EXPECT_NEAR(1000.0, meter.get_rate(1s), 0.001);
+  EXPECT_NEAR(1000.0, meter.get_rate(10s), 0.001);
+
+  // The shorter window forgets faster.
+  clock.add_seconds(2);
+  EXPECT_LT(meter.get_rate(1s), meter.get_rate(10s));
+}
+
+TEST(MeterTests, untracked_windows_are_an_error)
+{
+  using namespace std::chrono_literals;
+
+  ManualClock clock;
+  Meter meter{{30s}, 1s, &clock};
+
+  EXPECT_NO_THROW(meter.get_rate(30s));
+  EXPECT_THROW(meter.get_rate(1min), std::invalid_argument);
+  EXPECT_THROW(meter.get_m1_rate(), std::invalid_argument);
+}
+
+TEST(MeterTests, one_window_meters_track_their_window)
+{
+  using namespace std::chrono_literals;
+
+  ManualClock clock;
+  BasicMeter<ClockRef, 1> meter{{1min}, 5s, &clock};
+
+  meter.mark(10);
+  clock.add_seconds(5);
+  clock.add_nanos(1);
+  EXPECT_NEAR(2.0, meter.get_m1_rate(), 0.001);
+  EXPECT_THROW(meter.get_m5_rate(), std::invalid_argument);
+}
+
+TEST(MeterTests, windows_and_tick_intervals_must_be_positive)
+{
+  using namespace std::chrono_literals;
+
+  ManualClock clock;
+  EXPECT_THROW(Meter({1min}, 0s, &clock), std::invalid_argument);
+  EXPECT_THROW(Meter({1min}, -1s, &clock), std::invalid_argument);
+  EXPECT_THROW(Meter({}, 5s, &clock), std::invalid_argument);
+  EXPECT_THROW(Meter({1min, 0s}, 5s, &clock), std::invalid_argument);
+  EXPECT_THROW(Meter({-1min}, 5s, &clock), std::invalid_argument);
+  EXPECT_NO_THROW(Meter({1min}, 1ns, &clock));
+}
+
+TEST(MeterTests, steady_meters_read_the_clock_inline)
+{
+  SteadyMeter meter;
+  meter.mark(3);
+
+  EXPECT_EQ(3, meter.get_count());
+  EXPECT_LE(0.0, meter.get_mean_rate());
+  EXPECT_EQ(Meter::default_windows(), meter.get_windows());
+}
+
 }
+
+#else
+
+namespace {
+
+template <typename Metric>
+void bench(const char* name, std::size_t numThreads, std::size_t numIters)
+{
+  Metric meter;
+
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads);
+  for (std::size_t t = 0; t < numThreads; ++t)
+  {
+    threads.emplace_back([&]() {
+      for (std::size_t i = 0; i < numIters; ++i)
+      {
+        meter.mark();
+      }
+    });
+  }
+
+  for (auto&& t : threads)
+  {
+    t.join();
+  }
+
+  auto end = std::chrono::steady_clock::now();
+  auto millis = std::chrono::duration<double, std::milli>(end - start).count();
+  std::cerr << name << ", " << numThreads << " thread(s): " << millis << " ms, "
+            << (numThreads * numIters) / millis / 1000.0 << " M marks/s" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  using namespace cppmetrics;
+
+  constexpr const std::size_t numIters = 1000000;
+
+  for (std::size_t numThreads = 1; numThreads <= 64; numThreads *= 2)
+  {
+    bench<Meter>("Meter", numThreads, numIters);
+    bench<SteadyMeter>("SteadyMeter", numThreads, numIters);
+  }
+
+  return 0;
+}
+
+#endif
@@ -0,0 +1,231 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+// The Google Benchmark suite; see BUILD_BENCHMARKS.  Run it with
+// --benchmark_format=json, or build run_metrics_bench, for results that
+// can be compared between versions.
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <metrics/OStreamReporter.h>
+#include <metrics/metrics.h>
+
+namespace {
+
+using namespace cppmetrics;
+
+constexpr int kMaxThreads = 64;
+
+// Discards everything, so that reporting cost is just formatting.
+class NullBuffer : public std::streambuf
+{
+protected:
+  int overflow(int c) override { return c; }
+  std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+std::string metric_name(std::int64_t i)
+{
+  return "service.endpoint." + std::to_string(i) + ".requests";
+}
+
+// Fills a registry with |size| metrics, spread evenly across all types.
+std::shared_ptr<Registry> make_registry(std::int64_t size)
+{
+  auto registry = std::make_shared<Registry>();
+  for (std::int64_t i = 0; i < size; ++i)
+  {
+    auto name = metric_name(i);
+    switch (i % 5)
+    {
+    case 0: registry->counter(name)->inc(i); break;
+    case 1: registry->gauge(name)->set(i); break;
+    case 2: registry->meter(name)->mark(i); break;
+    case 3: registry->histogram(name)->update(i); break;
+    case 4: registry->timer(name)->update(std::chrono::nanoseconds(i)); break;
+    }
+  }
+  return registry;
+}
+
+// Multi-threaded benchmarks share one metric, created by the first thread
+// before the timed loop; Google Benchmark starts all threads together.
+template <typename T>
+std::unique_ptr<T>& shared()
+{
+  static std::unique_ptr<T> instance;
+  return instance;
+}
+
+void BM_CounterInc(benchmark::State& state)
+{
+  auto& counter = shared<Counter>();
+  if (state.thread_index() == 0)
+  {
+    counter = std::make_unique<Counter>();
+  }
+
+  for (auto _ : state)
+  {
+    counter->inc();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CounterInc)->ThreadRange(1, kMaxThreads)->UseRealTime();
+
+void BM_MeterMark(benchmark::State& state)
+{
+  auto& meter = shared<Meter>();
+  if (state.thread_index() == 0)
+  {
+    meter = std::make_unique<Meter>();
+  }
+
+  for (auto _ : state)
+  {
+    meter->mark();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MeterMark)->ThreadRange(1, kMaxThreads)->UseRealTime();
+
+void BM_HistogramUpdate(benchmark::State& state)
+{
+  auto& histogram = shared<Histogram>();
+  if (state.thread_index() == 0)
+  {
+    histogram = std::make_unique<Histogram>(std::make_unique<ExponentiallyDecayingReservoir>());
+  }
+
+  long value = 0;
+  for (auto _ : state)
+  {
+    histogram->update(value++ & 0xFFFF);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HistogramUpdate)->ThreadRange(1, kMaxThreads)->UseRealTime();
+
+void BM_ScopeTimer(benchmark::State& state)
+{
+  auto& timer = shared<Timer>();
+  if (state.thread_index() == 0)
+  {
+    timer = std::make_unique<Timer>();
+  }
+
+  for (auto _ : state)
+  {
+    ScopeTimer scope(*timer);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ScopeTimer)->ThreadRange(1, kMaxThreads)->UseRealTime();
+
+void BM_RegistryLookup(benchmark::State& state)
+{
+  static std::shared_ptr<Registry> registry;
+  if (state.thread_index() == 0)
+  {
+    registry = make_registry(state.range(0));
+  }
+
+  std::vector<std::string> names;
+  for (std::int64_t i = 0; i < state.range(0); i += 5)
+  {
+    names.push_back(metric_name(i));
+  }
+
+  std::size_t i = state.thread_index();
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(registry->counter(names[i++ % names.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RegistryLookup)
+    ->RangeMultiplier(8)->Range(8, 1 << 15)
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+
+void BM_FrozenRegistryLookup(benchmark::State& state)
+{
+  static std::shared_ptr<Registry> registry;
+  if (state.thread_index() == 0)
+  {
+    registry = make_registry(state.range(0));
+    registry->freeze();
+  }
+
+  std::vector<std::string> names;
+  for (std::int64_t i = 0; i < state.range(0); i += 5)
+  {
+    names.push_back(metric_name(i));
+  }
+
+  std::size_t i = state.thread_index();
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(registry->counter(names[i++ % names.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FrozenRegistryLookup)
+    ->RangeMultiplier(8)->Range(8, 1 << 15)
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+
+void BM_Snapshot(benchmark::State& state)
+{
+  Histogram histogram{std::make_unique<ExponentiallyDecayingReservoir>()};
+  for (std::int64_t i = 0; i < state.range(0); ++i)
+  {
+    histogram.update(i);
+  }
+
+  for (auto _ : state)
+  {
+    auto snapshot = histogram.get_snapshot();
+    benchmark::DoNotOptimize(snapshot->get_p99());
+  }
+}
+BENCHMARK(BM_Snapshot)->RangeMultiplier(4)->Range(16, 1028);
+
+void BM_OStreamReporterReport(benchmark::State& state)
+{
+  auto registry = make_registry(state.range(0));
+
+  NullBuffer buffer;
+  std::ostream out(&buffer);
+  OStreamReporter reporter{out, registry};
+
+  for (auto _ : state)
+  {
+    reporter.report();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_OStreamReporterReport)->RangeMultiplier(8)->Range(8, 1 << 12)->Unit(benchmark::kMicrosecond);
+
+}
+
+BENCHMARK_MAIN();
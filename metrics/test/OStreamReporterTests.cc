@@ -54,4 +54,27 @@ TEST_F(OStreamReporterTests, counter_reporting)
   EXPECT_EQ("test.ctr.1\t10\ntest.ctr.2\t15\n", ss.str());
 }
 
+TEST_F(OStreamReporterTests, gauge_reporting)
+{
+  registry->gauge("test.gauge")->set(42);
+  registry->double_gauge("test.double")->set(0.25);
+
+  auto hits = registry->counter("test.hits");
+  auto lookups = registry->counter("test.lookups");
+  hits->inc(1);
+  lookups->inc(4);
+  registry->add("test.ratio", std::make_shared<RatioGauge>(hits, lookups));
+
+  ss.str("");
+  reporter->report();
+
+  EXPECT_EQ(
+      "test.hits\t1\n"
+      "test.lookups\t4\n"
+      "test.gauge\t42\n"
+      "test.double\t0.25\n"
+      "test.ratio\t0.25\n",
+      ss.str());
+}
+
 }
@@ -0,0 +1,246 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+// The cppmetrics half of the parity benchmark; DropwizardParity.java is
+// the other half, and runs the same workloads the same way.  Each line of
+// output is a workload and its best mean nanoseconds per operation.
+//
+// Given the Java results file, this instead prints the two side by side,
+// and exits non-zero if cppmetrics is slower at anything.  The
+// run_parity_bench target does both, when a JDK is available.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <metrics/metrics.h>
+
+namespace {
+
+using namespace cppmetrics;
+
+// Keep these in step with DropwizardParity.java.
+constexpr std::uint64_t kOpsPerThread = 2000000;
+constexpr std::uint64_t kSnapshotOps = 2000;
+constexpr int kWarmupRounds = 3;
+constexpr int kRounds = 5;
+
+volatile double sink;
+
+// A single-use barrier, standing in for Java's CyclicBarrier.
+class Barrier
+{
+public:
+  explicit Barrier(unsigned parties)
+      : m_remaining(parties)
+  {}
+
+  void arrive_and_wait()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (--m_remaining == 0)
+    {
+      m_cv.notify_all();
+    }
+    else
+    {
+      m_cv.wait(lock, [this] { return m_remaining == 0; });
+    }
+  }
+
+private:
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  unsigned m_remaining;
+};
+
+// Times only the operations, between start and end barriers, so that
+// spawning and joining threads isn't counted - as the Java half does.
+template <typename Op>
+double nanos_per_op(unsigned threads, std::uint64_t ops_per_thread, const Op& op)
+{
+  Barrier start(threads + 1);
+  Barrier end(threads + 1);
+
+  std::vector<std::thread> workers;
+  for (unsigned t = 0; t < threads; ++t)
+  {
+    workers.emplace_back([&]
+    {
+      start.arrive_and_wait();
+      for (std::uint64_t i = 0; i < ops_per_thread; ++i)
+      {
+        op(i);
+      }
+      end.arrive_and_wait();
+    });
+  }
+
+  start.arrive_and_wait();
+  auto begin = std::chrono::steady_clock::now();
+  end.arrive_and_wait();
+  auto elapsed = std::chrono::steady_clock::now() - begin;
+
+  for (auto& worker : workers)
+  {
+    worker.join();
+  }
+  return std::chrono::duration<double, std::nano>(elapsed).count() / (ops_per_thread * threads);
+}
+
+// |workload| makes a fresh op for each round, which is passed on by
+// type so that calls to it can be inlined.
+template <typename Workload>
+double best(unsigned threads, std::uint64_t ops_per_thread, const Workload& workload)
+{
+  for (int i = 0; i < kWarmupRounds; ++i)
+  {
+    nanos_per_op(threads, ops_per_thread, workload());
+  }
+
+  double result = std::numeric_limits<double>::max();
+  for (int i = 0; i < kRounds; ++i)
+  {
+    result = std::min(result, nanos_per_op(threads, ops_per_thread, workload()));
+  }
+  return result;
+}
+
+std::vector<std::pair<std::string, double>> run()
+{
+  unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<unsigned> thread_counts{ 1 };
+  if (cpus > 1)
+  {
+    thread_counts.push_back(cpus);
+  }
+
+  std::vector<std::pair<std::string, double>> results;
+  auto record = [&](const std::string& name, double nanos)
+  {
+    std::cout << name << " " << std::fixed << std::setprecision(2) << nanos << std::endl;
+    results.emplace_back(name, nanos);
+  };
+
+  for (unsigned threads : thread_counts)
+  {
+    std::string suffix = "/" + std::to_string(threads);
+
+    record("counter.inc" + suffix, best(threads, kOpsPerThread, []
+    {
+      auto counter = std::make_shared<Counter>();
+      return [counter](std::uint64_t) { counter->inc(); };
+    }));
+
+    record("meter.mark" + suffix, best(threads, kOpsPerThread, []
+    {
+      auto meter = std::make_shared<Meter>();
+      return [meter](std::uint64_t) { meter->mark(); };
+    }));
+
+    record("histogram.update" + suffix, best(threads, kOpsPerThread, []
+    {
+      auto histogram = std::make_shared<Histogram>(std::make_unique<ExponentiallyDecayingReservoir>());
+      return [histogram](std::uint64_t i) { histogram->update(static_cast<long>(i & 1023)); };
+    }));
+  }
+
+  record("histogram.snapshot/1", best(1, kSnapshotOps, []
+  {
+    auto histogram = std::make_shared<Histogram>(std::make_unique<ExponentiallyDecayingReservoir>());
+    for (long i = 0; i < 10000; ++i)
+    {
+      histogram->update(i);
+    }
+    return [histogram](std::uint64_t) { sink = sink + histogram->get_snapshot()->get_p99(); };
+  }));
+
+  return results;
+}
+
+std::map<std::string, double> read_results(const std::string& path)
+{
+  std::map<std::string, double> results;
+  std::ifstream in(path);
+  std::string name;
+  double nanos;
+  while (in >> name >> nanos)
+  {
+    results[name] = nanos;
+  }
+  return results;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::map<std::string, double> dropwizard;
+  if (argc > 1)
+  {
+    dropwizard = read_results(argv[1]);
+    if (dropwizard.empty())
+    {
+      std::cerr << "No Dropwizard results in " << argv[1] << std::endl;
+      return 2;
+    }
+  }
+
+  auto results = run();
+  if (dropwizard.empty())
+  {
+    return 0;
+  }
+
+  std::cout << "\n"
+            << std::left << std::setw(24) << "workload"
+            << std::right << std::setw(14) << "cppmetrics" << std::setw(14) << "dropwizard"
+            << std::setw(10) << "speedup" << "\n";
+
+  int slower = 0;
+  for (auto&& result : results)
+  {
+    auto found = dropwizard.find(result.first);
+    if (found == dropwizard.end())
+    {
+      std::cout << std::left << std::setw(24) << result.first
+                << std::right << std::setw(14) << result.second << std::setw(14) << "-" << "\n";
+      continue;
+    }
+
+    double speedup = found->second / result.second;
+    std::cout << std::left << std::setw(24) << result.first
+              << std::right << std::setw(14) << result.second << std::setw(14) << found->second
+              << std::setw(9) << speedup << "x" << (speedup < 1.0 ? "  slower" : "") << "\n";
+    if (speedup < 1.0)
+    {
+      ++slower;
+    }
+  }
+
+  std::cout << "\n(nanoseconds per operation; thread counts after the slash)" << std::endl;
+  return slower > 0 ? 1 : 0;
+}
@@ -14,8 +14,39 @@
 
 #include <metrics/Registry.h>
 
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <metrics/Counter.h>
+
+namespace cppmetrics {
+
+inline std::string metric_name(std::size_t thread, std::size_t i)
+{
+  return "tenant." + std::to_string(thread) + ".metric." + std::to_string(i);
+}
+
+}
+
+#ifndef BENCH
+
 #include "gtest/gtest.h"
 
+#include <metrics/DoubleGauge.h>
+#include <metrics/ExponentiallyDecayingReservoir.h>
+#include <metrics/Gauge.h>
+#include <metrics/Meter.h>
+#include <metrics/RatioGauge.h>
+#include <metrics/Timer.h>
+
+#include "ManualClock.h"
+
 namespace cppmetrics {
 
 TEST(RegistryTest, foo)
@@ -27,4 +58,506 @@ TEST(RegistryTest, foo)
   EXPECT_EQ(1, registry.get_histograms().size());
 }
 
+TEST(RegistryTest, returns_the_same_metric_for_the_same_name)
+{
+  Registry registry;
+
+  auto first = registry.counter("foo");
+  auto second = registry.counter("foo");
+
+  EXPECT_EQ(first, second);
+}
+
+TEST(RegistryTest, returns_null_when_name_is_taken_by_another_type)
+{
+  Registry registry;
+
+  registry.counter("foo");
+
+  EXPECT_EQ(nullptr, registry.meter("foo"));
+  EXPECT_EQ(0, registry.get_meters().size());
+}
+
+TEST(RegistryTest, shard_count_is_rounded_up_to_a_power_of_two)
+{
+  Registry registry(5);
+
+  EXPECT_EQ(8, registry.shard_count());
+}
+
+TEST(RegistryTest, iteration_spans_all_shards_in_name_order)
+{
+  Registry registry(4);
+
+  for (int i = 0; i < 100; ++i)
+  {
+    registry.counter(metric_name(0, i))->inc(i);
+  }
+
+  auto counters = registry.get_counters();
+  ASSERT_EQ(100, counters.size());
+
+  std::string previous;
+  for (auto&& pair : counters)
+  {
+    EXPECT_LT(previous, pair.first);
+    previous = pair.first;
+  }
+}
+
+TEST(RegistryTest, concurrent_creation_yields_one_metric_per_name)
+{
+  Registry registry;
+
+  const std::size_t numThreads = 8;
+  const std::size_t numMetrics = 500;
+
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads);
+  for (std::size_t t = 0; t < numThreads; ++t)
+  {
+    threads.emplace_back([&]() {
+      // Every thread creates the same names, so each name is contended.
+      for (std::size_t i = 0; i < numMetrics; ++i)
+      {
+        registry.counter(metric_name(0, i))->inc();
+      }
+    });
+  }
+
+  for (auto&& t : threads)
+  {
+    t.join();
+  }
+
+  auto counters = registry.get_counters();
+  ASSERT_EQ(numMetrics, counters.size());
+  for (auto&& pair : counters)
+  {
+    EXPECT_EQ(numThreads, pair.second->get_count());
+  }
+}
+
+TEST(RegistryTest, remove_drops_a_metric_of_any_type)
+{
+  Registry registry;
+
+  registry.counter("foo");
+  registry.meter("bar");
+
+  EXPECT_TRUE(registry.remove("bar"));
+  EXPECT_FALSE(registry.remove("bar"));
+  EXPECT_FALSE(registry.remove("baz"));
+
+  EXPECT_EQ(1, registry.get_counters().size());
+  EXPECT_EQ(0, registry.get_meters().size());
+}
+
+TEST(RegistryTest, removed_names_can_be_reused_by_another_type)
+{
+  Registry registry;
+
+  registry.counter("foo");
+  registry.remove("foo");
+
+  EXPECT_NE(nullptr, registry.meter("foo"));
+}
+
+TEST(RegistryTest, remove_if_matches_names)
+{
+  Registry registry;
+
+  for (int i = 0; i < 10; ++i)
+  {
+    registry.counter(metric_name(1, i));
+    registry.counter(metric_name(2, i));
+  }
+
+  auto removed = registry.remove_if([](const std::string& name) {
+    return name.compare(0, 9, "tenant.1.") == 0;
+  });
+
+  EXPECT_EQ(10, removed);
+  for (auto&& pair : registry.get_counters())
+  {
+    EXPECT_EQ(0, pair.first.compare(0, 9, "tenant.2."));
+  }
+}
+
+TEST(RegistryTest, handles_outlive_removal)
+{
+  Registry registry;
+
+  auto counter = registry.counter("foo");
+  registry.remove("foo");
+
+  counter->inc(5);
+  EXPECT_EQ(5, counter->get_count());
+  EXPECT_NE(counter, registry.counter("foo"));
+}
+
+TEST(RegistryTest, evict_idle_does_nothing_without_a_ttl)
+{
+  Registry registry;
+
+  registry.counter("foo");
+
+  EXPECT_EQ(0, registry.evict_idle());
+  EXPECT_EQ(1, registry.get_counters().size());
+}
+
+TEST(RegistryTest, evict_idle_removes_only_idle_metrics)
+{
+  ManualClock clock;
+  Registry registry;
+  registry.set_idle_ttl(std::chrono::minutes(1), &clock);
+
+  auto busy = registry.counter("busy");
+  auto idle = registry.counter("idle");
+  auto meter = registry.meter("meter");
+
+  // Nothing is a full TTL old yet.
+  EXPECT_EQ(0, registry.evict_idle());
+
+  for (int i = 0; i < 4; ++i)
+  {
+    clock.add_seconds(30);
+    busy->inc();
+    registry.evict_idle();
+  }
+
+  auto counters = registry.get_counters();
+  EXPECT_EQ(1, counters.size());
+  EXPECT_EQ(1, counters.count("busy"));
+  EXPECT_EQ(0, registry.get_meters().size());
+
+  // The evicted handles are still usable.
+  idle->inc();
+  meter->mark();
+  EXPECT_EQ(1, idle->get_count());
+}
+
+TEST(RegistryTest, recently_updated_metrics_survive_eviction)
+{
+  ManualClock clock;
+  Registry registry;
+  registry.set_idle_ttl(std::chrono::seconds(10), &clock);
+
+  auto counter = registry.counter("foo");
+  registry.evict_idle();
+
+  clock.add_seconds(20);
+  counter->inc();
+
+  EXPECT_EQ(0, registry.evict_idle());
+  EXPECT_EQ(1, registry.get_counters().size());
+
+  clock.add_seconds(20);
+  EXPECT_EQ(1, registry.evict_idle());
+  EXPECT_EQ(0, registry.get_counters().size());
+}
+
+// A ManualClock that can be advanced while the ticker thread reads it.
+class SharedManualClock : public Clock
+{
+public:
+  std::chrono::nanoseconds tick() override
+  {
+    return std::chrono::nanoseconds(m_now.load());
+  }
+
+  void add_seconds(int seconds)
+  {
+    m_now += std::chrono::nanoseconds(std::chrono::seconds(seconds)).count();
+  }
+
+private:
+  std::atomic<long long> m_now{0};
+};
+
+// Polls |condition| until it holds, or a generous deadline passes.
+template <typename Condition>
+bool eventually(Condition&& condition)
+{
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (!condition())
+  {
+    if (std::chrono::steady_clock::now() > deadline)
+    {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+TEST(RegistryTest, ticker_starts_and_stops)
+{
+  SharedManualClock clock;
+  Registry registry;
+  auto before = std::make_shared<Meter>(&clock);
+  registry.add("before", before);
+
+  registry.start_ticker(std::chrono::milliseconds(1));
+  registry.start_ticker(); // no-op while running
+
+  auto after = std::make_shared<Timer>(std::make_unique<ExponentiallyDecayingReservoir>(), &clock, &clock);
+  registry.add("after", after);
+  for (int i = 0; i < 100; ++i)
+  {
+    before->mark();
+    after->update(std::chrono::milliseconds(1));
+  }
+
+  // Only the ticker moves the rates; reading them doesn't.
+  clock.add_seconds(6);
+  EXPECT_TRUE(eventually([&]() { return before->get_m1_rate() > 0.0; }));
+  EXPECT_TRUE(eventually([&]() { return after->get_m1_rate() > 0.0; }));
+  EXPECT_NEAR(20.0, before->get_m1_rate(), 0.001);
+  EXPECT_NEAR(20.0, after->get_m1_rate(), 0.001);
+
+  registry.stop_ticker();
+  registry.stop_ticker(); // no-op when stopped
+
+  EXPECT_EQ(100, before->get_count());
+  EXPECT_EQ(100, after->get_count());
+}
+
+TEST(RegistryTest, slow_tickers_spread_marks_over_missed_ticks)
+{
+  SharedManualClock clock;
+  Registry registry;
+  auto meter = std::make_shared<Meter>(&clock);
+  registry.add("meter", meter);
+
+  registry.start_ticker(std::chrono::milliseconds(1));
+
+  // 100 marks a second for a minute, between two of the ticker's reads.
+  meter->mark(6000);
+  clock.add_seconds(60);
+  EXPECT_TRUE(eventually([&]() { return meter->get_m1_rate() > 0.0; }));
+  EXPECT_NEAR(100.0, meter->get_m1_rate(), 0.001);
+
+  registry.stop_ticker();
+}
+
+TEST(RegistryTest, register_all_creates_missing_metrics)
+{
+  Registry registry;
+  registry.counter("a");
+
+  auto added = registry.register_all(MetricType::Counter, {"a", "b", "c", "c"});
+
+  EXPECT_EQ(2, added);
+  EXPECT_EQ(3, registry.get_counters().size());
+}
+
+TEST(RegistryTest, frozen_registry_returns_existing_metrics)
+{
+  Registry registry;
+
+  std::vector<std::string> names;
+  for (int i = 0; i < 5000; ++i)
+  {
+    names.push_back(metric_name(0, i));
+  }
+  registry.register_all(MetricType::Counter, names);
+  auto meter = registry.meter("meter");
+
+  auto before = registry.get_counters();
+  registry.freeze();
+  EXPECT_TRUE(registry.is_frozen());
+
+  for (auto&& pair : before)
+  {
+    EXPECT_EQ(pair.second, registry.counter(pair.first));
+  }
+  EXPECT_EQ(meter, registry.meter("meter"));
+  EXPECT_EQ(nullptr, registry.counter("meter"));
+}
+
+TEST(RegistryTest, frozen_registry_overflows_by_default)
+{
+  Registry registry;
+  registry.counter("frozen");
+  registry.freeze();
+
+  auto overflow = registry.counter("overflow");
+  EXPECT_NE(nullptr, overflow);
+  EXPECT_EQ(overflow, registry.counter("overflow"));
+  EXPECT_EQ(2, registry.get_counters().size());
+
+  // Overflow metrics are still removable; frozen ones are not.
+  EXPECT_TRUE(registry.remove("overflow"));
+  EXPECT_FALSE(registry.remove("frozen"));
+}
+
+TEST(RegistryTest, frozen_registry_can_reject_new_metrics)
+{
+  Registry registry;
+  auto counter = registry.counter("frozen");
+  registry.freeze(FreezePolicy::RejectNew);
+
+  EXPECT_EQ(counter, registry.counter("frozen"));
+  EXPECT_THROW(registry.counter("new"), std::logic_error);
+  EXPECT_THROW(registry.register_all(MetricType::Timer, {"new"}), std::logic_error);
+}
+
+TEST(RegistryTest, rejecting_registries_still_register_existing_names)
+{
+  Registry registry;
+  registry.register_all(MetricType::Counter, {"a", "b"});
+  registry.freeze(FreezePolicy::RejectNew);
+
+  EXPECT_EQ(0, registry.register_all(MetricType::Counter, {"a", "b", "a"}));
+  EXPECT_THROW(registry.register_all(MetricType::Counter, {"a", "c"}), std::logic_error);
+  EXPECT_EQ(2, registry.get_counters().size());
+}
+
+TEST(RegistryTest, refreezing_folds_in_overflow)
+{
+  Registry registry;
+  registry.counter("first");
+  registry.freeze();
+
+  auto second = registry.counter("second");
+  registry.freeze(FreezePolicy::RejectNew);
+
+  EXPECT_EQ(second, registry.counter("second"));
+  EXPECT_FALSE(registry.remove("second"));
+}
+
+TEST(RegistryTest, callback_gauges_are_evaluated_when_read)
+{
+  Registry registry;
+  long depth = 3;
+
+  auto gauge = registry.gauge("queue.depth", [&]() { return depth; });
+  depth = 5;
+
+  EXPECT_EQ(5, registry.get_gauges().at("queue.depth")->get());
+  EXPECT_EQ(gauge, registry.gauge("queue.depth", [] { return 0L; }));
+}
+
+TEST(RegistryTest, computed_gauges_cannot_be_fetched_for_setting)
+{
+  Registry registry;
+  registry.gauge("queue.depth", [] { return 3L; });
+
+  EXPECT_EQ(nullptr, registry.gauge("queue.depth"));
+  EXPECT_EQ(3, registry.get_gauges().at("queue.depth")->get());
+}
+
+TEST(RegistryTest, computed_double_gauges_cannot_be_fetched_for_setting)
+{
+  Registry registry;
+  auto hits = registry.counter("cache.hits");
+  auto lookups = registry.counter("cache.lookups");
+  registry.add("cache.hit_ratio", std::make_shared<RatioGauge>(hits, lookups));
+
+  hits->inc(1);
+  lookups->inc(2);
+
+  EXPECT_EQ(nullptr, registry.double_gauge("cache.hit_ratio"));
+  EXPECT_EQ(0.5, registry.get_double_gauges().at("cache.hit_ratio")->get());
 }
+
+TEST(RegistryTest, cached_gauges_are_registered_like_any_other)
+{
+  Registry registry;
+  int calls = 0;
+
+  auto gauge = registry.gauge("cache.size", [&]() { return static_cast<long>(++calls); }, std::chrono::hours(1));
+
+  EXPECT_EQ(1, gauge->get());
+  EXPECT_EQ(1, registry.get_gauges().at("cache.size")->get());
+  EXPECT_EQ(1, calls);
+}
+
+}
+
+#else
+
+int main(int argc, char** argv)
+{
+  using namespace cppmetrics;
+
+  const std::size_t numThreads = argc > 1 ? std::atoi(argv[1]) : std::thread::hardware_concurrency();
+  const std::size_t numMetrics = 10000; // per thread
+  const std::size_t numLookups = 10;    // per metric
+
+  for (std::size_t shards : {1, 4, 16, 64})
+  {
+    Registry registry(shards);
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads);
+    for (std::size_t t = 0; t < numThreads; ++t)
+    {
+      threads.emplace_back([&registry, t, numMetrics, numLookups]() {
+        // Each thread stands in for a new tenant, creating its own metrics
+        // and immediately using them.
+        for (std::size_t i = 0; i < numMetrics; ++i)
+        {
+          auto name = metric_name(t, i);
+          for (std::size_t j = 0; j < numLookups; ++j)
+          {
+            registry.counter(name)->inc();
+          }
+        }
+      });
+    }
+
+    for (auto&& t : threads)
+    {
+      t.join();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    auto duration = end - start;
+    std::cerr << shards << " shard(s), " << numThreads << " thread(s): "
+              << std::chrono::duration<double, std::milli>(duration).count() << " ms, "
+              << registry.get_counters().size() << " counters" << std::endl;
+
+    // Now the lookup-only steady state, before and after freezing.
+    for (bool frozen : {false, true})
+    {
+      if (frozen)
+      {
+        registry.freeze();
+      }
+
+      start = std::chrono::steady_clock::now();
+      threads.clear();
+      for (std::size_t t = 0; t < numThreads; ++t)
+      {
+        threads.emplace_back([&registry, t, numMetrics, numLookups]() {
+          for (std::size_t i = 0; i < numMetrics; ++i)
+          {
+            auto name = metric_name(t, i);
+            for (std::size_t j = 0; j < numLookups; ++j)
+            {
+              registry.counter(name)->inc();
+            }
+          }
+        });
+      }
+
+      for (auto&& t : threads)
+      {
+        t.join();
+      }
+
+      end = std::chrono::steady_clock::now();
+      duration = end - start;
+      std::cerr << "  lookups" << (frozen ? " (frozen)" : "") << ": "
+                << std::chrono::duration<double, std::milli>(duration).count() << " ms" << std::endl;
+    }
+  }
+
+  return 0;
+}
+
+#endif
@@ -0,0 +1,329 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/Sampler.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <metrics/ExponentiallyDecayingReservoir.h>
+#include <metrics/Histogram.h>
+#include <metrics/SampledHistogram.h>
+#include <metrics/SampledTimer.h>
+#include <metrics/Snapshot.h>
+
+#ifndef BENCH
+
+#include "gtest/gtest.h"
+
+#include "ManualClock.h"
+
+namespace cppmetrics {
+
+// Counts how often it is read.
+class CountingClock : public ManualClock
+{
+public:
+  std::chrono::nanoseconds tick() override
+  {
+    ++m_reads;
+    return ManualClock::tick();
+  }
+
+  int reads() const
+  {
+    return m_reads;
+  }
+
+private:
+  int m_reads = 0;
+};
+
+// Remembers the weight of every update.
+class WeightRecordingReservoir : public Reservoir
+{
+public:
+  std::size_t size() const override
+  {
+    return m_weights.size();
+  }
+
+  void update(long value) override
+  {
+    update_weighted(value, 1);
+  }
+
+  void update_weighted(long, double weight) override
+  {
+    m_weights.push_back(weight);
+  }
+
+  std::shared_ptr<Snapshot> get_snapshot() override
+  {
+    return nullptr;
+  }
+
+  const std::vector<double>& weights() const
+  {
+    return m_weights;
+  }
+
+private:
+  std::vector<double> m_weights;
+};
+
+TEST(SamplerTests, samples_one_in_n)
+{
+  Sampler sampler{10};
+
+  int sampled = 0;
+  for (int i = 0; i < 1000; ++i)
+  {
+    if (sampler.should_sample())
+    {
+      ++sampled;
+    }
+  }
+
+  EXPECT_EQ(100, sampled);
+  EXPECT_FALSE(sampler.is_adaptive());
+}
+
+TEST(SamplerTests, many_samplers_keep_their_own_rates)
+{
+  // More than 64 samplers, with neighbours 64 apart at different rates,
+  // so that any wrapping table of countdowns would mix them up.
+  std::vector<std::unique_ptr<Sampler>> samplers;
+  for (int i = 0; i < 130; ++i)
+  {
+    samplers.push_back(std::make_unique<Sampler>((i / 64) % 2 == 0 ? 2 : 1000));
+  }
+
+  std::vector<int> sampled(samplers.size(), 0);
+  for (int round = 0; round < 10000; ++round)
+  {
+    for (std::size_t i = 0; i < samplers.size(); ++i)
+    {
+      if (samplers[i]->should_sample())
+      {
+        ++sampled[i];
+      }
+    }
+  }
+
+  for (std::size_t i = 0; i < samplers.size(); ++i)
+  {
+    EXPECT_EQ((i / 64) % 2 == 0 ? 5000 : 10, sampled[i]) << "sampler " << i;
+  }
+}
+
+TEST(SamplerTests, intervals_are_clamped)
+{
+  EXPECT_EQ(1u, Sampler{0}.get_interval());
+  EXPECT_EQ(Sampler::kMaxInterval, Sampler{0xFFFFFFFF}.get_interval());
+}
+
+TEST(SamplerTests, adaptive_samplers_back_off_when_over_budget)
+{
+  ManualClock clock;
+  Sampler sampler{1, 100, &clock};
+  ASSERT_TRUE(sampler.is_adaptive());
+
+  for (int i = 0; i < 1000; ++i)
+  {
+    sampler.should_sample();
+  }
+  EXPECT_GT(sampler.get_interval(), 1u);
+}
+
+TEST(SamplerTests, adaptive_samplers_recover_when_under_budget)
+{
+  ManualClock clock;
+  Sampler sampler{64, 1000, &clock};
+
+  // One sampled event a second is far under budget.
+  for (int i = 0; i < 64 * 10; ++i)
+  {
+    if (i % 64 == 0)
+    {
+      clock.add_seconds(1);
+    }
+    sampler.should_sample();
+  }
+  EXPECT_LT(sampler.get_interval(), 64u);
+}
+
+TEST(SampledHistogramTests, counts_everything_and_records_a_sample)
+{
+  SampledHistogram histogram{std::make_unique<ExponentiallyDecayingReservoir>(), 4};
+
+  for (int i = 0; i < 400; ++i)
+  {
+    histogram.update(i);
+  }
+
+  EXPECT_EQ(400, histogram.get_count());
+  EXPECT_EQ(100, histogram.get_recorded_count());
+  EXPECT_EQ(100u, histogram.get_snapshot()->size());
+  EXPECT_EQ(4u, histogram.get_sample_interval());
+}
+
+TEST(SampledHistogramTests, counts_are_exact_across_threads)
+{
+  SampledHistogram histogram{std::make_unique<ExponentiallyDecayingReservoir>(), 16};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+  {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < 1600; ++i)
+      {
+        histogram.update(i);
+      }
+    });
+  }
+
+  for (auto&& t : threads)
+  {
+    t.join();
+  }
+
+  EXPECT_EQ(6400, histogram.get_count());
+  EXPECT_EQ(400, histogram.get_recorded_count());
+}
+
+TEST(SampledHistogramTests, samples_are_weighted_by_their_interval)
+{
+  auto reservoir = std::make_unique<WeightRecordingReservoir>();
+  auto& weights = reservoir->weights();
+  SampledHistogram histogram{std::move(reservoir), 10};
+
+  for (int i = 0; i < 100; ++i)
+  {
+    histogram.update(i);
+  }
+
+  ASSERT_EQ(10u, weights.size());
+  for (auto weight : weights)
+  {
+    EXPECT_EQ(10.0, weight);
+  }
+}
+
+TEST(SampledHistogramTests, adaptive_weights_account_for_every_event)
+{
+  ManualClock clock;
+  auto reservoir = std::make_unique<WeightRecordingReservoir>();
+  auto& weights = reservoir->weights();
+  SampledHistogram histogram{std::move(reservoir), 1, 100, &clock};
+
+  // Far over budget, so the interval grows as we go.
+  for (int i = 0; i < 100000; ++i)
+  {
+    histogram.update(i);
+  }
+
+  double total = 0;
+  double heaviest = 0;
+  for (auto weight : weights)
+  {
+    total += weight;
+    heaviest = std::max(heaviest, weight);
+  }
+
+  EXPECT_GT(heaviest, 1.0);
+  EXPECT_NEAR(100000.0, total, heaviest);
+}
+
+TEST(SampledTimerTests, only_sampled_scopes_read_the_clock)
+{
+  CountingClock clock;
+  SampledTimer timer{std::make_unique<ExponentiallyDecayingReservoir>(), 10, &clock};
+  auto baseline = clock.reads();
+
+  for (int i = 0; i < 100; ++i)
+  {
+    SampledTimer::Scope scope(timer);
+  }
+
+  EXPECT_EQ(100, timer.get_count());
+  EXPECT_EQ(10u, timer.get_snapshot()->size());
+  EXPECT_EQ(20, clock.reads() - baseline);
+}
+
+TEST(SampledTimerTests, rates_count_every_event)
+{
+  ManualClock clock;
+  SampledTimer timer{std::make_unique<ExponentiallyDecayingReservoir>(), 8, &clock};
+
+  for (int i = 0; i < 50; ++i)
+  {
+    timer.update(std::chrono::milliseconds(1));
+  }
+
+  clock.add_seconds(5);
+  EXPECT_NEAR(10.0, timer.get_m1_rate(), 0.001);
+  EXPECT_NEAR(10.0, timer.get_mean_rate(), 0.001);
+}
+
+}
+
+#else
+
+namespace {
+
+using namespace cppmetrics;
+
+template <typename Fn>
+void bench(const char* name, std::size_t numIters, Fn&& fn)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < numIters; ++i)
+  {
+    fn(static_cast<long>(i & 0xFFFF));
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  auto nanos = std::chrono::duration<double, std::nano>(end - start).count();
+  std::cerr << name << ": " << nanos / numIters << " ns/update" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  constexpr const std::size_t numIters = 1000000;
+
+  Histogram histogram{std::make_unique<ExponentiallyDecayingReservoir>()};
+  bench("Histogram", numIters, [&](long v) { histogram.update(v); });
+
+  for (std::uint32_t interval : { 16u, 256u })
+  {
+    SampledHistogram sampled{std::make_unique<ExponentiallyDecayingReservoir>(), interval};
+    std::string name = "SampledHistogram, 1 in " + std::to_string(interval);
+    bench(name.c_str(), numIters, [&](long v) { sampled.update(v); });
+  }
+
+  SampledHistogram adaptive{std::make_unique<ExponentiallyDecayingReservoir>(), 1, 10000};
+  bench("SampledHistogram, adaptive", numIters, [&](long v) { adaptive.update(v); });
+  std::cerr << "  settled on 1 in " << adaptive.get_sample_interval() << std::endl;
+
+  return 0;
+}
+
+#endif
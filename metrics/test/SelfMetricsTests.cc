@@ -0,0 +1,292 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/SelfMetrics.h>
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include <metrics/metrics.h>
+#include <metrics/Reporter.h>
+#include <metrics/ScheduledReporter.h>
+
+#include "ManualClock.h"
+
+namespace cppmetrics {
+
+using namespace std::chrono_literals;
+
+class SelfMetricsTests : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    // Only takes effect before the first test enables self metrics, which
+    // is all we need: the self timers then all run on this clock.
+    SelfMetrics::set_clock(&clock());
+  }
+
+  void TearDown() override
+  {
+    SelfMetrics::set_enabled(false);
+  }
+
+  // Self metrics are process-wide, so tests look at changes rather than totals.
+  static long count_of(const std::string& name)
+  {
+    for (auto&& counter : SelfMetrics::get_counters())
+    {
+      if (counter.first == name)
+      {
+        return counter.second->get_count();
+      }
+    }
+    for (auto&& timer : SelfMetrics::get_timers())
+    {
+      if (timer.first == name)
+      {
+        return timer.second->get_count();
+      }
+    }
+    return -1;
+  }
+
+  static ManualClock& clock()
+  {
+    static ManualClock instance;
+    return instance;
+  }
+};
+
+class NullReporter : public Reporter
+{
+public:
+  void report() override {}
+};
+
+// Blocks the |n|th call to tick() until released.
+class BlockingClock : public Clock
+{
+public:
+  explicit BlockingClock(int n)
+    : m_block_at(n)
+    , m_calls(0)
+  {}
+
+  std::chrono::nanoseconds tick() override
+  {
+    if (++m_calls == m_block_at)
+    {
+      m_entered.set_value();
+      m_release.get_future().wait();
+    }
+    return std::chrono::nanoseconds(0);
+  }
+
+  std::time_t now_as_time_t() override
+  {
+    return 0;
+  }
+
+  void wait_until_blocked()
+  {
+    m_entered.get_future().wait();
+  }
+
+  void release()
+  {
+    m_release.set_value();
+  }
+
+private:
+  int m_block_at;
+  std::atomic<int> m_calls;
+  std::promise<void> m_entered;
+  std::promise<void> m_release;
+};
+
+TEST_F(SelfMetricsTests, nothing_is_collected_while_disabled)
+{
+  Registry registry;
+  auto lookups = count_of("registry.lookups");
+
+  registry.counter("foo");
+  registry.counter("foo");
+
+  EXPECT_EQ(lookups, count_of("registry.lookups"));
+}
+
+TEST_F(SelfMetricsTests, enabling_registers_every_self_metric)
+{
+  Registry registry;
+  registry.enable_self_metrics("self");
+
+  EXPECT_TRUE(SelfMetrics::is_enabled());
+
+  auto counters = registry.get_counters();
+  EXPECT_EQ(1u, counters.count("self.long_adder.cas_failures"));
+  EXPECT_EQ(1u, counters.count("self.long_adder.rehashes"));
+  EXPECT_EQ(1u, counters.count("self.registry.lookups"));
+  EXPECT_EQ(1u, counters.count("self.registry.creations"));
+
+  auto timers = registry.get_timers();
+  EXPECT_EQ(1u, timers.count("self.reporter.report"));
+  EXPECT_EQ(1u, timers.count("self.snapshot.build"));
+  EXPECT_EQ(1u, timers.count("self.reservoir.rescale"));
+  EXPECT_EQ(1u, timers.count("self.reservoir.lock_wait"));
+}
+
+TEST_F(SelfMetricsTests, counts_registry_lookups_and_creations)
+{
+  Registry registry;
+  registry.enable_self_metrics();
+
+  auto lookups = count_of("registry.lookups");
+  auto creations = count_of("registry.creations");
+
+  registry.counter("foo");
+  registry.counter("foo");
+  registry.meter("bar");
+  registry.register_all(MetricType::Gauge, { "baz", "quux" });
+
+  EXPECT_EQ(lookups + 3, count_of("registry.lookups"));
+  EXPECT_EQ(creations + 4, count_of("registry.creations"));
+}
+
+TEST_F(SelfMetricsTests, times_reporter_passes)
+{
+  SelfMetrics::set_enabled(true);
+  auto passes = count_of("reporter.report");
+
+  ScheduledReporter reporter{std::make_unique<NullReporter>(), 1s};
+  reporter.report();
+  reporter.report();
+
+  EXPECT_EQ(passes + 2, count_of("reporter.report"));
+}
+
+TEST_F(SelfMetricsTests, times_snapshots_and_rescales)
+{
+  SelfMetrics::set_enabled(true);
+  auto snapshots = count_of("snapshot.build");
+  auto rescales = count_of("reservoir.rescale");
+
+  ManualClock clock;
+  ExponentiallyDecayingReservoir reservoir{1028, 0.015, &clock};
+  reservoir.update(1);
+  reservoir.get_snapshot();
+
+  clock.add_hours(1);
+  reservoir.update(2);
+
+  EXPECT_EQ(snapshots + 1, count_of("snapshot.build"));
+  EXPECT_EQ(rescales + 1, count_of("reservoir.rescale"));
+}
+
+TEST_F(SelfMetricsTests, rescaling_a_self_timer_records_into_itself)
+{
+  Registry registry;
+  registry.enable_self_metrics();
+
+  auto rescales = registry.get_timers().at("cppmetrics.reservoir.rescale");
+  rescales->update(std::chrono::milliseconds(1));
+  auto before = rescales->get_count();
+
+  // The snapshot rescales the timer's own reservoir, and records that
+  // into the same reservoir; it must not still hold its lock by then.
+  clock().add_minutes(2);
+  rescales->get_snapshot();
+
+  EXPECT_EQ(before + 1, rescales->get_count());
+}
+
+TEST_F(SelfMetricsTests, times_contended_reservoir_lock_waits)
+{
+  SelfMetrics::set_enabled(true);
+  auto waits = count_of("reservoir.lock_wait");
+
+  // Tick 1 is construction, 2 the rescale check, and 3 happens with the
+  // lock held; the first update stalls there, and the second waits on it.
+  BlockingClock clock{3};
+  ExponentiallyDecayingReservoir reservoir{1028, 0.015, &clock};
+
+  std::thread holder([&] { reservoir.update(1); });
+  clock.wait_until_blocked();
+
+  std::thread waiter([&] { reservoir.update(2); });
+  std::this_thread::sleep_for(200ms);
+  clock.release();
+
+  holder.join();
+  waiter.join();
+
+  EXPECT_EQ(waits + 1, count_of("reservoir.lock_wait"));
+}
+
+TEST_F(SelfMetricsTests, counts_long_adder_cas_failures_and_rehashes)
+{
+  SelfMetrics::set_enabled(true);
+  auto failures = count_of("long_adder.cas_failures");
+  auto rehashes = count_of("long_adder.rehashes");
+
+  // Failures need two threads to race on one cell, so keep racing
+  // until one shows up.
+  Counter counter;
+  std::atomic_bool done{false};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i)
+  {
+    threads.emplace_back([&]
+    {
+      auto deadline = std::chrono::steady_clock::now() + 10s;
+      while (!done && std::chrono::steady_clock::now() < deadline)
+      {
+        for (int j = 0; j < 10000; ++j)
+        {
+          counter.inc();
+        }
+        done = count_of("long_adder.cas_failures") > failures;
+      }
+    });
+  }
+  for (auto&& thread : threads)
+  {
+    thread.join();
+  }
+
+  EXPECT_GT(count_of("long_adder.cas_failures"), failures);
+  EXPECT_GT(count_of("long_adder.rehashes"), rehashes);
+}
+
+TEST_F(SelfMetricsTests, disabling_stops_collection)
+{
+  Registry registry;
+  registry.enable_self_metrics();
+  SelfMetrics::set_enabled(false);
+
+  auto lookups = count_of("registry.lookups");
+  registry.counter("foo");
+
+  EXPECT_EQ(lookups, count_of("registry.lookups"));
+}
+
+} // namespace cppmetrics
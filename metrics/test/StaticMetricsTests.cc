@@ -0,0 +1,86 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/StaticMetrics.h>
+
+#include "gtest/gtest.h"
+
+namespace cppmetrics { namespace test {
+
+CPPMETRICS_COUNTER(requests_total);
+CPPMETRICS_METER_NAMED(request_rate, "requests.rate");
+CPPMETRICS_HISTOGRAM(response_sizes);
+CPPMETRICS_TIMER(request_latency);
+CPPMETRICS_GAUGE(queue_depth);
+
+TEST(StaticMetricsTests, are_usable_without_a_registry)
+{
+  requests_total.inc(3);
+  EXPECT_EQ(3, requests_total.get_count());
+
+  Counter& counter = requests_total.metric();
+  counter.dec(3);
+  EXPECT_EQ(0, requests_total.get_count());
+}
+
+TEST(StaticMetricsTests, are_linked_at_static_init)
+{
+  std::size_t count = 0;
+  for (auto metric = StaticMetricBase::head(); metric != nullptr; metric = metric->next())
+  {
+    ++count;
+  }
+
+  EXPECT_EQ(5, count);
+}
+
+TEST(StaticMetricsTests, register_into_a_registry_by_reference)
+{
+  Registry registry;
+
+  EXPECT_EQ(5, registry.register_static_metrics());
+
+  auto counter = registry.counter("requests_total");
+  EXPECT_EQ(&requests_total.metric(), counter.get());
+  EXPECT_EQ(&request_rate.metric(), registry.meter("requests.rate").get());
+  EXPECT_EQ(1, registry.get_histograms().size());
+  EXPECT_EQ(1, registry.get_timers().size());
+  EXPECT_EQ(1, registry.get_gauges().size());
+
+  // A second pass finds nothing new.
+  EXPECT_EQ(0, registry.register_static_metrics());
+}
+
+TEST(StaticMetricsTests, removal_does_not_destroy_the_metric)
+{
+  {
+    Registry registry;
+    registry.register_static_metrics();
+    registry.remove("queue_depth");
+  }
+
+  queue_depth.set(12);
+  EXPECT_EQ(12, queue_depth.get());
+}
+
+TEST(StaticMetricsTests, names_already_taken_are_skipped)
+{
+  Registry registry;
+  registry.meter("requests_total");
+
+  EXPECT_EQ(4, registry.register_static_metrics());
+  EXPECT_EQ(0, registry.get_counters().size());
+}
+
+}}
@@ -0,0 +1,668 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+// A contention-scaling and false-sharing stress harness, built with the
+// tests as metrics_stress.
+//
+// Threads are pinned to CPUs chosen by placement:
+//
+//   same-cpu  every thread on one logical CPU (oversubscription)
+//   smt       the hardware threads of one physical core
+//   socket    one logical CPU per physical core, all on one socket
+//   cross     one logical CPU per physical core, alternating sockets
+//
+// and thread counts are swept in powers of two up to what the placement
+// allows.  Each point reports throughput, p99 latency of a single operation
+// (sampled once per batch, with clock overhead subtracted), and last-level
+// cache misses per operation when perf_event_open is permitted.
+//
+// A point whose throughput falls below --collapse times the best seen at a
+// lower thread count for the same workload and placement is flagged as a
+// collapse.  With --baseline, every point is also compared against a CSV
+// written by an earlier --csv run and flagged when it is more than
+// --tolerance slower.  Any flag makes the exit status non-zero.
+//
+// A point whose threads could not all be pinned - the CPU was taken away by
+// a cgroup, say - is marked UNPINNED, is neither flagged nor written to the
+// CSV, and ends its placement's sweep.
+//
+// Pinning, topology and perf counters are Linux-only; elsewhere only the
+// same-cpu placement runs, unpinned.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <metrics/metrics.h>
+
+namespace {
+
+using namespace cppmetrics;
+
+using stress_clock = std::chrono::steady_clock;
+
+constexpr std::uint64_t kBatch = 256;
+
+struct Options
+{
+  std::chrono::milliseconds duration{200};
+  unsigned max_threads = 0; // 0 means every CPU the placement offers
+  unsigned oversubscribe = 4; // thread cap for same-cpu
+  double collapse = 0.5;
+  double tolerance = 0.25;
+  std::set<std::string> workloads;
+  std::set<std::string> placements;
+  std::string csv_path;
+  std::string baseline_path;
+};
+
+// Topology
+
+struct Cpu
+{
+  int id;
+  int core;
+  int socket;
+};
+
+#ifdef __linux__
+
+int read_int(const std::string& path, int fallback)
+{
+  std::ifstream in(path);
+  int value;
+  return (in >> value) ? value : fallback;
+}
+
+std::vector<Cpu> read_topology()
+{
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+  {
+    return {};
+  }
+
+  std::vector<Cpu> cpus;
+  for (int id = 0; id < CPU_SETSIZE; ++id)
+  {
+    if (!CPU_ISSET(id, &allowed))
+    {
+      continue;
+    }
+
+    std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(id) + "/topology/";
+    cpus.push_back({ id, read_int(dir + "core_id", id), read_int(dir + "physical_package_id", 0) });
+  }
+  return cpus;
+}
+
+// Returns false if the thread could not be pinned.
+bool pin_to(int cpu)
+{
+  if (cpu < 0)
+  {
+    return true;
+  }
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+// Counts last-level cache misses for the calling thread, user space only.
+class CacheMissCounter
+{
+public:
+  CacheMissCounter()
+  {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    m_fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+
+  ~CacheMissCounter()
+  {
+    if (m_fd >= 0)
+    {
+      close(m_fd);
+    }
+  }
+
+  bool available() const { return m_fd >= 0; }
+
+  void start()
+  {
+    if (available())
+    {
+      ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+
+  std::uint64_t stop()
+  {
+    std::uint64_t value = 0;
+    if (available())
+    {
+      ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(m_fd, &value, sizeof(value)) != sizeof(value))
+      {
+        value = 0;
+      }
+    }
+    return value;
+  }
+
+private:
+  int m_fd;
+};
+
+#else
+
+std::vector<Cpu> read_topology()
+{
+  return {};
+}
+
+bool pin_to(int)
+{
+  return true;
+}
+
+class CacheMissCounter
+{
+public:
+  bool available() const { return false; }
+  void start() {}
+  std::uint64_t stop() { return 0; }
+};
+
+#endif
+
+// Each placement is an ordered list of CPUs; thread i runs on cpus[i].
+// An entry of -1 leaves the thread unpinned.
+std::map<std::string, std::vector<int>> make_placements(const std::vector<Cpu>& topology, const Options& options)
+{
+  std::map<std::string, std::vector<int>> placements;
+
+  int first_cpu = topology.empty() ? -1 : topology.front().id;
+  placements["same-cpu"] = std::vector<int>(options.oversubscribe, first_cpu);
+
+  if (topology.empty())
+  {
+    return placements;
+  }
+
+  // (socket, core) -> logical CPUs
+  std::map<std::pair<int, int>, std::vector<int>> cores;
+  for (const auto& cpu : topology)
+  {
+    cores[{ cpu.socket, cpu.core }].push_back(cpu.id);
+  }
+
+  for (const auto& core : cores)
+  {
+    if (core.second.size() > 1)
+    {
+      placements["smt"] = core.second;
+      break;
+    }
+  }
+
+  std::map<int, std::vector<int>> per_socket;
+  for (const auto& core : cores)
+  {
+    per_socket[core.first.first].push_back(core.second.front());
+  }
+
+  placements["socket"] = per_socket.begin()->second;
+
+  if (per_socket.size() > 1)
+  {
+    std::vector<int> cross;
+    for (std::size_t i = 0; ; ++i)
+    {
+      bool any = false;
+      for (const auto& socket : per_socket)
+      {
+        if (i < socket.second.size())
+        {
+          cross.push_back(socket.second[i]);
+          any = true;
+        }
+      }
+      if (!any)
+      {
+        break;
+      }
+    }
+    placements["cross"] = cross;
+  }
+
+  return placements;
+}
+
+// Workloads; each op() is one operation on a metric shared by all threads.
+
+struct LongAdderWorkload
+{
+  LongAdder adder;
+
+  void op(std::uint64_t) { adder.incr(); }
+};
+
+struct MeterWorkload
+{
+  Meter meter;
+
+  void op(std::uint64_t) { meter.mark(); }
+};
+
+struct HistogramWorkload
+{
+  Histogram histogram{ std::make_unique<ExponentiallyDecayingReservoir>() };
+
+  void op(std::uint64_t i) { histogram.update(static_cast<long>(i & 1023)); }
+};
+
+struct RegistryWorkload
+{
+  static constexpr std::size_t kNames = 64;
+
+  Registry registry;
+  std::vector<std::string> names;
+
+  RegistryWorkload()
+  {
+    for (std::size_t i = 0; i < kNames; ++i)
+    {
+      names.push_back("stress.counter." + std::to_string(i));
+      registry.counter(names.back());
+    }
+  }
+
+  void op(std::uint64_t i) { registry.counter(names[i % kNames])->inc(); }
+};
+
+// Running a point
+
+struct Result
+{
+  double ops_per_second;
+  double p99_ns;
+  double misses_per_op; // negative when perf counters are unavailable
+  bool pinned;
+};
+
+struct ThreadResult
+{
+  std::uint64_t ops = 0;
+  std::uint64_t misses = 0;
+  bool perf = false;
+  bool pinned = false;
+  std::vector<double> latencies;
+};
+
+double clock_overhead_ns()
+{
+  double best = 1e9;
+  for (int i = 0; i < 1000; ++i)
+  {
+    auto start = stress_clock::now();
+    auto end = stress_clock::now();
+    best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count());
+  }
+  return best;
+}
+
+template <typename Workload>
+Result run_point(const std::vector<int>& cpus, unsigned threads, const Options& options, double overhead_ns)
+{
+  Workload workload;
+
+  std::atomic<unsigned> ready{0};
+  std::atomic_bool go{false};
+  std::atomic_bool stop{false};
+  std::vector<ThreadResult> results(threads);
+  std::vector<std::thread> workers;
+
+  for (unsigned t = 0; t < threads; ++t)
+  {
+    workers.emplace_back([&, t]
+    {
+      ThreadResult& result = results[t];
+      result.pinned = pin_to(cpus[t]);
+      result.latencies.reserve(1 << 16);
+      CacheMissCounter misses;
+
+      ready.fetch_add(1);
+      while (!go.load(std::memory_order_acquire))
+      {
+        std::this_thread::yield();
+      }
+
+      misses.start();
+      std::uint64_t i = 0;
+      while (!stop.load(std::memory_order_relaxed))
+      {
+        for (std::uint64_t end = i + kBatch; i < end; ++i)
+        {
+          workload.op(i);
+        }
+
+        auto start = stress_clock::now();
+        workload.op(i++);
+        auto elapsed = std::chrono::duration<double, std::nano>(stress_clock::now() - start).count();
+        result.latencies.push_back(std::max(0.0, elapsed - overhead_ns));
+      }
+      result.misses = misses.stop();
+      result.perf = misses.available();
+      result.ops = i;
+    });
+  }
+
+  while (ready.load() < threads)
+  {
+    std::this_thread::yield();
+  }
+
+  auto start = stress_clock::now();
+  go.store(true, std::memory_order_release);
+  std::this_thread::sleep_for(options.duration);
+  stop.store(true);
+  for (auto& worker : workers)
+  {
+    worker.join();
+  }
+  double seconds = std::chrono::duration<double>(stress_clock::now() - start).count();
+
+  std::uint64_t ops = 0;
+  std::uint64_t misses = 0;
+  bool perf = true;
+  bool pinned = true;
+  std::vector<double> latencies;
+  for (const auto& result : results)
+  {
+    ops += result.ops;
+    misses += result.misses;
+    perf = perf && result.perf;
+    pinned = pinned && result.pinned;
+    latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+  }
+
+  double p99 = 0;
+  if (!latencies.empty())
+  {
+    auto rank = latencies.begin() + static_cast<std::ptrdiff_t>((latencies.size() - 1) * 99 / 100);
+    std::nth_element(latencies.begin(), rank, latencies.end());
+    p99 = *rank;
+  }
+
+  return {
+    ops / seconds,
+    p99,
+    perf && ops > 0 ? static_cast<double>(misses) / ops : -1.0,
+    pinned
+  };
+}
+
+using Runner = Result (*)(const std::vector<int>&, unsigned, const Options&, double);
+
+const std::vector<std::pair<std::string, Runner>>& workloads()
+{
+  static const std::vector<std::pair<std::string, Runner>> all = {
+    { "longadder", &run_point<LongAdderWorkload> },
+    { "meter",     &run_point<MeterWorkload> },
+    { "histogram", &run_point<HistogramWorkload> },
+    { "registry",  &run_point<RegistryWorkload> },
+  };
+  return all;
+}
+
+std::vector<unsigned> thread_counts(unsigned limit)
+{
+  std::vector<unsigned> counts;
+  for (unsigned n = 1; n < limit; n *= 2)
+  {
+    counts.push_back(n);
+  }
+  counts.push_back(limit);
+  return counts;
+}
+
+// Baselines
+
+using Key = std::tuple<std::string, std::string, unsigned>;
+
+std::map<Key, double> read_baseline(const std::string& path)
+{
+  std::map<Key, double> baseline;
+  std::ifstream in(path);
+  std::string line;
+  std::getline(in, line); // header
+  while (std::getline(in, line))
+  {
+    std::istringstream fields(line);
+    std::string workload, placement, threads, ops;
+    if (std::getline(fields, workload, ',') && std::getline(fields, placement, ',')
+        && std::getline(fields, threads, ',') && std::getline(fields, ops, ','))
+    {
+      baseline[Key{ workload, placement, std::stoul(threads) }] = std::stod(ops);
+    }
+  }
+  return baseline;
+}
+
+std::set<std::string> split(const std::string& list)
+{
+  std::set<std::string> items;
+  std::istringstream in(list);
+  std::string item;
+  while (std::getline(in, item, ','))
+  {
+    items.insert(item);
+  }
+  return items;
+}
+
+void usage(const char* argv0)
+{
+  std::cerr << "usage: " << argv0 << " [options]\n"
+            << "  --duration-ms=N       time per point (default 200)\n"
+            << "  --max-threads=N       cap every placement at N threads\n"
+            << "  --oversubscribe=N     threads for the same-cpu placement (default 4)\n"
+            << "  --workloads=a,b       longadder,meter,histogram,registry\n"
+            << "  --placements=a,b      same-cpu,smt,socket,cross\n"
+            << "  --collapse=F          flag throughput below F x the best lower count (default 0.5)\n"
+            << "  --csv=PATH            write results as CSV\n"
+            << "  --baseline=PATH       compare against an earlier --csv run\n"
+            << "  --tolerance=F         allowed slowdown against the baseline (default 0.25)\n";
+}
+
+bool parse(int argc, char** argv, Options& options)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    auto eq = arg.find('=');
+    std::string key = arg.substr(0, eq);
+    std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+    if (key == "--duration-ms") options.duration = std::chrono::milliseconds(std::stol(value));
+    else if (key == "--max-threads") options.max_threads = static_cast<unsigned>(std::stoul(value));
+    else if (key == "--oversubscribe") options.oversubscribe = static_cast<unsigned>(std::stoul(value));
+    else if (key == "--workloads") options.workloads = split(value);
+    else if (key == "--placements") options.placements = split(value);
+    else if (key == "--collapse") options.collapse = std::stod(value);
+    else if (key == "--csv") options.csv_path = value;
+    else if (key == "--baseline") options.baseline_path = value;
+    else if (key == "--tolerance") options.tolerance = std::stod(value);
+    else return false;
+  }
+  return options.oversubscribe > 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  Options options;
+  if (!parse(argc, argv, options))
+  {
+    usage(argv[0]);
+    return 2;
+  }
+
+  auto placements = make_placements(read_topology(), options);
+  std::map<Key, double> baseline;
+  if (!options.baseline_path.empty())
+  {
+    baseline = read_baseline(options.baseline_path);
+  }
+
+  std::ofstream csv;
+  if (!options.csv_path.empty())
+  {
+    csv.open(options.csv_path);
+    csv << std::fixed;
+    csv << "workload,placement,threads,ops_per_second,p99_ns,cache_misses_per_op\n";
+  }
+
+  double overhead_ns = clock_overhead_ns();
+  int flagged = 0;
+
+  std::cout << std::left
+            << std::setw(11) << "workload" << std::setw(10) << "placement" << std::setw(9) << "threads"
+            << std::setw(14) << "Mops/s" << std::setw(10) << "p99 ns" << std::setw(14) << "misses/op" << "\n";
+
+  for (const auto& workload : workloads())
+  {
+    if (!options.workloads.empty() && options.workloads.count(workload.first) == 0)
+    {
+      continue;
+    }
+
+    for (const auto& placement : placements)
+    {
+      if (!options.placements.empty() && options.placements.count(placement.first) == 0)
+      {
+        continue;
+      }
+
+      unsigned limit = static_cast<unsigned>(placement.second.size());
+      if (options.max_threads > 0)
+      {
+        limit = std::min(limit, options.max_threads);
+      }
+
+      double best = 0;
+      for (unsigned threads : thread_counts(limit))
+      {
+        Result result = workload.second(placement.second, threads, options, overhead_ns);
+
+        std::ostringstream misses;
+        if (result.misses_per_op >= 0)
+        {
+          misses << std::fixed << std::setprecision(3) << result.misses_per_op;
+        }
+        else
+        {
+          misses << "n/a";
+        }
+
+        std::string verdict;
+        if (!result.pinned)
+        {
+          // Not the placement it claims to be, so not comparable with anything.
+          verdict = "  UNPINNED";
+        }
+        else
+        {
+          if (best > 0 && result.ops_per_second < best * options.collapse)
+          {
+            verdict += "  COLLAPSE";
+          }
+          auto found = baseline.find(Key{ workload.first, placement.first, threads });
+          if (found != baseline.end() && result.ops_per_second < found->second * (1.0 - options.tolerance))
+          {
+            verdict += "  REGRESSION";
+          }
+          if (!verdict.empty())
+          {
+            ++flagged;
+          }
+          best = std::max(best, result.ops_per_second);
+        }
+
+        std::cout << std::setw(11) << workload.first << std::setw(10) << placement.first << std::setw(9) << threads
+                  << std::setw(14) << std::fixed << std::setprecision(2) << result.ops_per_second / 1e6
+                  << std::setw(10) << std::setprecision(0) << result.p99_ns
+                  << std::setw(14) << misses.str() << verdict << std::endl;
+
+        if (!result.pinned)
+        {
+          break;
+        }
+
+        if (csv.is_open())
+        {
+          csv << workload.first << "," << placement.first << "," << threads << ","
+              << std::setprecision(0) << result.ops_per_second << ","
+              << std::setprecision(1) << result.p99_ns << ","
+              << misses.str() << "\n";
+        }
+      }
+    }
+  }
+
+  if (flagged > 0)
+  {
+    std::cout << flagged << " point(s) flagged" << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -15,6 +15,12 @@
 #include <metrics/Timer.h>
 
 #include <chrono>
+#include <thread>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && __has_include(<coroutine>)
+#include <coroutine>
+#endif
 
 #include "gtest/gtest.h"
 
@@ -97,4 +103,240 @@ TEST(TimerTests, times_runnables)
   EXPECT_GT(timer.get_snapshot()->get_mean(), 0.0);
 }
 
+TEST(TimerTests, rates_can_use_a_separate_clock)
+{
+  ManualClock clock;
+  ManualClock rate_clock;
+  Timer timer(std::make_unique<ExponentiallyDecayingReservoir>(), &clock, &rate_clock);
+
+  timer.update(std::chrono::milliseconds(1));
+  clock.add_seconds(6);
+  EXPECT_EQ(0.0, timer.get_m1_rate());
+
+  rate_clock.add_seconds(6);
+  EXPECT_NEAR(0.2, timer.get_m1_rate(), 0.001);
+}
+
+TEST(TimerTests, steady_timers_time_scopes)
+{
+  SteadyTimer timer;
+
+  auto result = timed(timer, []() { return 42; });
+  {
+    SteadyScopeTimer scope(timer);
+  }
+
+  EXPECT_EQ(42, result);
+  EXPECT_EQ(2, timer.get_count());
+  EXPECT_LE(0, timer.get_snapshot()->get_min());
+}
+
+TEST(TimerTests, update_batch_drops_negative_durations)
+{
+  Timer timer;
+
+  std::vector<long> nanos{ 1000, -1, 3000 };
+  timer.update_batch(nanos.data(), nanos.size());
+
+  EXPECT_EQ(2, timer.get_count());
+  EXPECT_EQ(2u, timer.get_snapshot()->size());
+  EXPECT_EQ(1000, timer.get_snapshot()->get_min());
+}
+
+TEST(TimerTests, contexts_stop_exactly_once)
+{
+  ManualClock clock;
+  Timer timer(std::make_unique<ExponentiallyDecayingReservoir>(), &clock);
+
+  {
+    auto context = timer.time();
+    EXPECT_TRUE(context.is_running());
+
+    clock.add_millis(10);
+    EXPECT_EQ(std::chrono::milliseconds(10), context.stop());
+    EXPECT_FALSE(context.is_running());
+    EXPECT_EQ(std::chrono::nanoseconds::zero(), context.stop());
+  }
+
+  EXPECT_EQ(1, timer.get_count());
+}
+
+TEST(TimerTests, contexts_stop_when_destroyed)
+{
+  ManualClock clock;
+  Timer timer(std::make_unique<ExponentiallyDecayingReservoir>(), &clock);
+
+  {
+    auto context = timer.time();
+    clock.add_millis(5);
+  }
+
+  EXPECT_EQ(1, timer.get_count());
+  EXPECT_EQ(5000000, timer.get_snapshot()->get_max());
+}
+
+TEST(TimerTests, contexts_can_be_moved_across_threads)
+{
+  Timer timer;
+
+  auto context = timer.time();
+  std::thread worker([context = std::move(context)]() mutable {
+    context.stop();
+  });
+  worker.join();
+
+  EXPECT_FALSE(context.is_running());
+  EXPECT_EQ(1, timer.get_count());
+}
+
+TEST(TimerTests, assigning_over_a_running_context_stops_it)
+{
+  ManualClock clock;
+  Timer timer(std::make_unique<ExponentiallyDecayingReservoir>(), &clock);
+
+  auto first = timer.time();
+  clock.add_millis(1);
+  first = timer.time();
+  EXPECT_EQ(1, timer.get_count());
+
+  first.stop();
+  EXPECT_EQ(2, timer.get_count());
+}
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && __has_include(<coroutine>)
+
+struct FireAndForget
+{
+  struct promise_type
+  {
+    FireAndForget get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() {}
+  };
+};
+
+struct ManualEvent
+{
+  std::coroutine_handle<> waiter;
+
+  bool await_ready() { return false; }
+  void await_suspend(std::coroutine_handle<> handle) { waiter = handle; }
+  int await_resume() { return 42; }
+};
+
+FireAndForget await_timed(Timer& timer, ManualEvent& event, int& result)
+{
+  result = co_await timed_await(timer, event);
+}
+
+TEST(TimerTests, times_co_await_regions)
+{
+  ManualClock clock;
+  Timer timer(std::make_unique<ExponentiallyDecayingReservoir>(), &clock);
+  ManualEvent event;
+  int result = 0;
+
+  await_timed(timer, event, result);
+  EXPECT_EQ(0, timer.get_count());
+
+  clock.add_millis(7);
+  event.waiter.resume();
+
+  EXPECT_EQ(42, result);
+  EXPECT_EQ(1, timer.get_count());
+  EXPECT_EQ(7000000, timer.get_snapshot()->get_max());
+}
+
+FireAndForget await_later(Timer& timer, ManualEvent& gate, ManualEvent& event, int& result)
+{
+  auto awaiter = timed_await(timer, event);
+  co_await gate;
+  result = co_await awaiter;
+}
+
+TEST(TimerTests, co_await_timing_starts_at_the_co_await)
+{
+  ManualClock clock;
+  Timer timer(std::make_unique<ExponentiallyDecayingReservoir>(), &clock);
+  ManualEvent gate;
+  ManualEvent event;
+  int result = 0;
+
+  await_later(timer, gate, event, result);
+  clock.add_millis(5);
+  gate.waiter.resume();
+
+  clock.add_millis(7);
+  event.waiter.resume();
+
+  EXPECT_EQ(42, result);
+  EXPECT_EQ(1, timer.get_count());
+  EXPECT_EQ(7000000, timer.get_snapshot()->get_max());
+}
+
+TEST(TimerTests, co_awaits_abandoned_while_suspended_are_not_recorded)
+{
+  ManualClock clock;
+  Timer timer(std::make_unique<ExponentiallyDecayingReservoir>(), &clock);
+  ManualEvent event;
+  int result = 0;
+
+  await_timed(timer, event, result);
+  clock.add_millis(7);
+  event.waiter.destroy();
+
+  EXPECT_EQ(0, result);
+  EXPECT_EQ(0, timer.get_count());
+}
+
+// Awaitable through a member operator co_await, as many libraries' tasks are.
+struct MemberAwaitable
+{
+  ManualEvent event;
+
+  ManualEvent& operator co_await() { return event; }
+};
+
+// And through a free one.
+struct FreeAwaitable
+{
+  ManualEvent event;
+};
+
+ManualEvent& operator co_await(FreeAwaitable& awaitable)
+{
+  return awaitable.event;
+}
+
+template <typename Awaitable>
+FireAndForget await_awaitable(Timer& timer, Awaitable& awaitable, int& result)
+{
+  result = co_await timed_await(timer, awaitable);
+}
+
+TEST(TimerTests, co_await_finds_the_awaiter_through_operator_co_await)
+{
+  ManualClock clock;
+  Timer timer(std::make_unique<ExponentiallyDecayingReservoir>(), &clock);
+  MemberAwaitable member;
+  FreeAwaitable free;
+  int member_result = 0;
+  int free_result = 0;
+
+  await_awaitable(timer, member, member_result);
+  await_awaitable(timer, free, free_result);
+  clock.add_millis(3);
+  member.event.waiter.resume();
+  free.event.waiter.resume();
+
+  EXPECT_EQ(42, member_result);
+  EXPECT_EQ(42, free_result);
+  EXPECT_EQ(2, timer.get_count());
+  EXPECT_EQ(3000000, timer.get_snapshot()->get_max());
+}
+
+#endif
+
 }
@@ -0,0 +1,127 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/TscClock.h>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <time.h>
+#endif
+
+namespace {
+
+std::int64_t monotonic_nanos()
+{
+#if defined(_WIN32)
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+#else
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<std::int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+}
+
+#ifndef BENCH
+
+#include "gtest/gtest.h"
+
+namespace cppmetrics {
+
+using namespace std::chrono_literals;
+
+TEST(TscClockTests, never_goes_backwards)
+{
+  TscClock clock{1ms};
+
+  auto last = clock.tick();
+  for (int i = 0; i < 1000000; ++i)
+  {
+    auto now = clock.tick();
+    ASSERT_GE(now, last);
+    last = now;
+  }
+}
+
+TEST(TscClockTests, tracks_the_monotonic_clock)
+{
+  TscClock clock{10ms};
+
+  for (int i = 0; i < 5; ++i)
+  {
+    std::this_thread::sleep_for(20ms);
+    auto error = clock.tick().count() - monotonic_nanos();
+    EXPECT_LT(std::abs(error), std::chrono::nanoseconds(1ms).count());
+  }
+}
+
+TEST(TscClockTests, shared_instance)
+{
+  EXPECT_NE(nullptr, GetTscClock());
+  EXPECT_EQ(GetTscClock(), GetTscClock());
+}
+
+}
+
+#else
+
+#include <algorithm>
+#include <cstdlib>
+
+int main(int argc, char** argv)
+{
+  using namespace cppmetrics;
+
+  // Seconds to spend measuring drift; ten minutes unless told otherwise.
+  auto seconds = argc > 1 ? std::atoi(argv[1]) : 600;
+
+  constexpr const std::size_t numIters = 10000000;
+
+  std::cerr << "invariant counter: " << (TscClock::is_supported() ? "yes" : "no") << std::endl;
+
+  auto measure = [&](const char* name, Clock* clock) {
+    std::int64_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < numIters; ++i)
+    {
+      sink += clock->tick().count();
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto nanos = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cerr << name << ": " << nanos / numIters << " ns/call (" << (sink & 1) << ")" << std::endl;
+  };
+
+  TscClock tsc;
+  measure("default clock", GetDefaultClock());
+  measure("tsc clock", &tsc);
+
+  std::int64_t worst = 0;
+  for (int i = 0; i < seconds; ++i)
+  {
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    auto error = std::abs(tsc.tick().count() - monotonic_nanos());
+    worst = std::max(worst, error);
+  }
+  std::cerr << "max error over " << seconds << "s: " << worst << " ns" << std::endl;
+
+  return 0;
+}
+
+#endif
@@ -0,0 +1,236 @@
+//  Copyright 2019 Benjamin Bader
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <metrics/WindowedRate.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifndef BENCH
+
+#include "gtest/gtest.h"
+
+#include "ManualClock.h"
+
+namespace cppmetrics {
+
+using namespace std::chrono_literals;
+
+TEST(WindowedRateTests, starts_with_zero)
+{
+  ManualClock clock;
+  WindowedRate rate{60s, &clock};
+
+  EXPECT_EQ(0, rate.get_count());
+  EXPECT_EQ(0.0, rate.get_rate());
+  EXPECT_EQ(0.0, rate.get_rate(1s));
+}
+
+TEST(WindowedRateTests, marks_count_once_their_second_is_complete)
+{
+  ManualClock clock;
+  WindowedRate rate{60s, &clock};
+
+  rate.mark(10);
+  EXPECT_EQ(10, rate.get_count());
+  EXPECT_EQ(0.0, rate.get_rate(1s));
+
+  clock.add_seconds(1);
+  EXPECT_EQ(10.0, rate.get_rate(1s));
+  EXPECT_EQ(5.0, rate.get_rate(2s));
+}
+
+TEST(WindowedRateTests, rates_are_exact_over_any_window)
+{
+  ManualClock clock;
+  WindowedRate rate{10s, &clock};
+
+  // One mark in the first second, two in the second, and so on.
+  for (int i = 1; i <= 10; ++i)
+  {
+    rate.mark(i);
+    clock.add_seconds(1);
+  }
+
+  EXPECT_EQ(10.0, rate.get_rate(1s));
+  EXPECT_EQ((10.0 + 9.0 + 8.0) / 3, rate.get_rate(3s));
+  EXPECT_EQ(55.0 / 10, rate.get_rate(10s));
+}
+
+TEST(WindowedRateTests, old_marks_slide_out_of_the_window)
+{
+  ManualClock clock;
+  WindowedRate rate{5s, &clock};
+
+  rate.mark(100);
+  clock.add_seconds(1);
+  EXPECT_EQ(20.0, rate.get_rate());
+
+  clock.add_seconds(4);
+  EXPECT_EQ(20.0, rate.get_rate());
+
+  clock.add_seconds(1);
+  EXPECT_EQ(0.0, rate.get_rate());
+
+  // Idling for far longer than the horizon is no different.
+  rate.mark(5);
+  clock.add_hours(1);
+  EXPECT_EQ(0.0, rate.get_rate());
+  EXPECT_EQ(105, rate.get_count());
+}
+
+TEST(WindowedRateTests, windows_must_fit_the_horizon)
+{
+  ManualClock clock;
+  WindowedRate rate{5s, &clock};
+
+  EXPECT_THROW(rate.get_rate(0s), std::invalid_argument);
+  EXPECT_THROW(rate.get_rate(6s), std::invalid_argument);
+  EXPECT_THROW(WindowedRate(0s, &clock), std::invalid_argument);
+}
+
+TEST(WindowedRateTests, marks_from_many_threads_are_all_counted)
+{
+  ManualClock clock;
+  WindowedRate rate{60s, &clock};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t)
+  {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < 10000; ++i)
+      {
+        rate.mark();
+      }
+    });
+  }
+
+  for (auto&& t : threads)
+  {
+    t.join();
+  }
+
+  clock.add_seconds(1);
+  EXPECT_EQ(80000, rate.get_count());
+  EXPECT_EQ(80000.0, rate.get_rate(1s));
+}
+
+// A ManualClock that one thread can advance while others read it.
+class SharedManualClock : public Clock
+{
+public:
+  std::chrono::nanoseconds tick() override
+  {
+    return std::chrono::nanoseconds(m_now.load());
+  }
+
+  void add_seconds(int seconds)
+  {
+    m_now += std::chrono::nanoseconds(std::chrono::seconds(seconds)).count();
+  }
+
+private:
+  std::atomic<long long> m_now{0};
+};
+
+TEST(WindowedRateTests, readers_never_see_a_half_rotated_ring)
+{
+  SharedManualClock clock;
+  WindowedRate rate{2s, &clock};
+
+  // One mark a second, as fast as possible, so rotations are constant.
+  std::atomic_bool done{false};
+  std::thread writer([&]() {
+    for (int i = 0; i < 200000; ++i)
+    {
+      clock.add_seconds(1);
+      rate.mark();
+    }
+    done = true;
+  });
+
+  int bad = 0;
+  while (!done)
+  {
+    auto r = rate.get_rate(2s);
+    if (r < 0.0 || r > 1.0)
+    {
+      ++bad;
+    }
+  }
+  writer.join();
+
+  EXPECT_EQ(0, bad);
+}
+
+}
+
+#else
+
+#include <metrics/Meter.h>
+
+namespace {
+
+template <typename Metric>
+void bench(const char* name, std::size_t numThreads, std::size_t numIters)
+{
+  Metric metric;
+
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads);
+  for (std::size_t t = 0; t < numThreads; ++t)
+  {
+    threads.emplace_back([&]() {
+      for (std::size_t i = 0; i < numIters; ++i)
+      {
+        metric.mark();
+      }
+    });
+  }
+
+  for (auto&& t : threads)
+  {
+    t.join();
+  }
+
+  auto end = std::chrono::steady_clock::now();
+  auto millis = std::chrono::duration<double, std::milli>(end - start).count();
+  std::cerr << name << ", " << numThreads << " thread(s): " << millis << " ms, "
+            << (numThreads * numIters) / millis / 1000.0 << " M marks/s" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  using namespace cppmetrics;
+
+  constexpr const std::size_t numIters = 1000000;
+
+  for (std::size_t numThreads = 1; numThreads <= 64; numThreads *= 2)
+  {
+    bench<Meter>("Meter", numThreads, numIters);
+    bench<WindowedRate>("WindowedRate", numThreads, numIters);
+  }
+
+  return 0;
+}
+
+#endif